@@ -0,0 +1,29 @@
+#include "defines.h"
+#include "EncodingShader.h"
+
+static ShadingProgram encodingShadingProgram("shaders/image.vs", "shaders/encoding.fs");
+
+EncodingShader::EncodingShader(): Shader()
+{
+    // static program shader
+    program_ = &encodingShadingProgram;
+    // reset instance
+    reset();
+}
+
+void EncodingShader::use()
+{
+    Shader::use();
+
+    program_->setUniform("plane", (int) plane);
+}
+
+void EncodingShader::reset()
+{
+    Shader::reset();
+
+    // conversion does not blend
+    blending = BLEND_CUSTOM;
+
+    plane = PLANE_Y;
+}
@@ -0,0 +1,37 @@
+#ifndef ENCODINGSHADER_H
+#define ENCODINGSHADER_H
+
+#ifdef __APPLE__
+#include <sys/types.h>
+#endif
+
+#include "Shader.h"
+
+/**
+ * @brief The EncodingShader class converts an RGB(A) image into
+ * one plane of a YUV frame (BT.709, limited range).
+ *
+ * It is used by the VideoRecorder to render each plane of the frames
+ * to encode into a single channel frame buffer, which size gives the
+ * chroma subsampling (e.g. half width and height for I420).
+ */
+class EncodingShader : public Shader
+{
+
+public:
+
+    typedef enum {
+        PLANE_Y = 0,
+        PLANE_U,
+        PLANE_V
+    } Plane;
+
+    EncodingShader();
+
+    void use() override;
+    void reset() override;
+
+    Plane plane;
+};
+
+#endif // ENCODINGSHADER_H
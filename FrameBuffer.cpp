@@ -187,6 +187,41 @@ bool FrameBuffer::blit(FrameBuffer *other)
     return true;
 }
 
+void FrameBuffer::resize(uint width, uint height)
+{
+    if ( width < 1 || height < 1 || (width == this->width() && height == this->height()) )
+        return;
+
+    glm::ivec2 previous = attrib_.viewport;
+    attrib_.viewport = glm::ivec2(width, height);
+
+    // not created yet
+    if (!framebufferid_)
+        return;
+
+    // keep the previous buffers to copy their content
+    uint textureid = textureid_, intermediate_textureid = intermediate_textureid_;
+    uint framebufferid = framebufferid_, intermediate_framebufferid = intermediate_framebufferid_;
+    textureid_ = intermediate_textureid_ = 0;
+    framebufferid_ = intermediate_framebufferid_ = 0;
+    init();
+
+    // scale the resolved content into the new buffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, use_multi_sampling_ ? intermediate_framebufferid : framebufferid);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, use_multi_sampling_ ? intermediate_framebufferid_ : framebufferid_);
+    glBlitFramebuffer(0, 0, previous.x, previous.y, 0, 0, attrib_.viewport.x, attrib_.viewport.y,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    FrameBuffer::release();
+
+    // free previous buffers
+    glDeleteFramebuffers(1, &framebufferid);
+    glDeleteTextures(1, &textureid);
+    if (intermediate_framebufferid)
+        glDeleteFramebuffers(1, &intermediate_framebufferid);
+    if (intermediate_textureid)
+        glDeleteTextures(1, &intermediate_textureid);
+}
+
 void FrameBuffer::checkFramebufferStatus()
 {
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
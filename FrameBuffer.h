@@ -30,6 +30,8 @@ public:
     // bind the FrameBuffer in READ and perform glReadPixels
     // return the size of the buffer
     void readPixels();
+    // change resolution, keeping the content (scaled)
+    void resize(uint width, uint height);
 
     // clear color
     inline void setClearColor(glm::vec4 color) { attrib_.clear_color = color; }
@@ -2,6 +2,10 @@
 #include <iomanip>
 using namespace std;
 
+#include <gst/app/gstappsink.h>
+
+#include "Log.h"
+#include "SystemToolkit.h"
 #include "GstToolkit.h"
 
 string GstToolkit::time_to_string(guint64 t, time_string_mode m)
@@ -111,6 +115,245 @@ bool GstToolkit::enable_feature (string name, bool enable) {
 }
 
 
+bool GstToolkit::set_feature_rank (string name, guint rank) {
+    GstRegistry *registry = NULL;
+    GstElementFactory *factory = NULL;
+
+    registry = gst_registry_get();
+    if (!registry) return false;
+
+    factory = gst_element_factory_find (name.c_str());
+    if (!factory) return false;
+
+    gst_plugin_feature_set_rank (GST_PLUGIN_FEATURE (factory), rank);
+
+    gst_registry_add_feature (registry, GST_PLUGIN_FEATURE (factory));
+    return true;
+}
+
+// link the video stream to the element given, discard others
+static void link_video_pad (GstElement *, GstPad *pad, gpointer p)
+{
+    GstElement *element = (GstElement *) p;
+    GstPad *sinkpad = gst_element_get_static_pad (element, "sink");
+
+    GstCaps *caps = gst_pad_get_current_caps (pad);
+    if (caps == NULL)
+        caps = gst_pad_query_caps (pad, NULL);
+    const gchar *name = gst_caps_get_size (caps) > 0 ? gst_structure_get_name (gst_caps_get_structure (caps, 0)) : "";
+
+    if ( !gst_pad_is_linked (sinkpad) && g_str_has_prefix (name, "video/") )
+        gst_pad_link (pad, sinkpad);
+    else {
+        GstElement *fake = gst_element_factory_make ("fakesink", NULL);
+        gst_bin_add (GST_BIN (GST_ELEMENT_PARENT (element)), fake);
+        gst_element_sync_state_with_parent (fake);
+        GstPad *fakepad = gst_element_get_static_pad (fake, "sink");
+        gst_pad_link (pad, fakepad);
+        gst_object_unref (fakepad);
+    }
+
+    gst_caps_unref (caps);
+    gst_object_unref (sinkpad);
+}
+
+string GstToolkit::video_stream_caps(const string &uri)
+{
+    string caps;
+
+    // demux and parse without decoding
+    GError *error = NULL;
+    string description = "urisourcebin uri=" + uri + " ! parsebin name=parse";
+    GstElement *pipeline = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        g_clear_error (&error);
+        if (pipeline)
+            gst_object_unref (pipeline);
+        return caps;
+    }
+
+    GstElement *sink = gst_element_factory_make ("appsink", "sink");
+    gst_bin_add (GST_BIN (pipeline), sink);
+    GstElement *parse = gst_bin_get_by_name (GST_BIN (pipeline), "parse");
+    g_signal_connect (G_OBJECT(parse), "pad-added", G_CALLBACK (link_video_pad), sink);
+    gst_object_unref (parse);
+
+    // caps of the first buffer of the video stream
+    if ( gst_element_set_state (pipeline, GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE ) {
+        GstSample *sample = gst_app_sink_try_pull_preroll (GST_APP_SINK(sink), 5 * GST_SECOND);
+        if (sample) {
+            GstCaps *c = gst_sample_get_caps (sample);
+            if (c) {
+                gchar *s = gst_caps_to_string (c);
+                caps = string(s);
+                g_free (s);
+            }
+            gst_sample_unref (sample);
+        }
+    }
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+
+    return caps;
+}
+
+list<string> GstToolkit::video_decoders(const string &caps)
+{
+    list<string> decoderlist;
+
+    GstCaps *c = gst_caps_from_string (caps.c_str());
+    if (!c)
+        return decoderlist;
+
+    // video decoders which can be auto-plugged (not those disabled, nor of rank none)
+    GList *decoders = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_DECODER |
+                                                             GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, GST_RANK_MARGINAL);
+    GList *l = gst_element_factory_list_filter (decoders, c, GST_PAD_SINK, FALSE);
+    l = g_list_sort (l, (GCompareFunc) gst_plugin_feature_rank_compare_func);
+
+    for (GList *g = l; g; g = g->next) {
+        GstPluginFeature *feature = GST_PLUGIN_FEATURE (g->data);
+        decoderlist.push_back( string( gst_plugin_feature_get_name (feature) ) );
+    }
+
+    gst_plugin_feature_list_free (l);
+    gst_plugin_feature_list_free (decoders);
+    gst_caps_unref (c);
+
+    return decoderlist;
+}
+
+GstToolkit::decoder_benchmark GstToolkit::benchmark_decoder(const string &uri, const string &decoder, double seconds)
+{
+    decoder_benchmark result = { decoder, 0.0, 0.0 };
+
+    // demux, parse and decode as fast as possible
+    GError *error = NULL;
+    string description = "urisourcebin uri=" + uri + " ! parsebin name=parse ";
+    description += decoder + " name=decoder ! appsink name=sink sync=false";
+    GstElement *pipeline = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        g_clear_error (&error);
+        if (pipeline)
+            gst_object_unref (pipeline);
+        return result;
+    }
+
+    GstElement *parse = gst_bin_get_by_name (GST_BIN (pipeline), "parse");
+    GstElement *dec = gst_bin_get_by_name (GST_BIN (pipeline), "decoder");
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+    g_signal_connect (G_OBJECT(parse), "pad-added", G_CALLBACK (link_video_pad), dec);
+
+    if ( gst_element_set_state (pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE ) {
+
+        // count frames decoded
+        guint64 frames = 0;
+        gint64 start = g_get_monotonic_time ();
+        double cpu_start = SystemToolkit::cpu_time();
+        gint64 elapsed = 0;
+        while ( elapsed < static_cast<gint64>(seconds * 1000000.0) ) {
+            GstSample *sample = gst_app_sink_try_pull_sample (GST_APP_SINK(sink), GST_SECOND);
+            elapsed = g_get_monotonic_time () - start;
+            if (sample == NULL)
+                break;
+            gst_sample_unref (sample);
+            frames++;
+        }
+
+        if ( elapsed > 0 && frames > 1 ) {
+            double wall = static_cast<double>(elapsed) * 0.000001;
+            result.fps = static_cast<double>(frames) / wall;
+            result.cpu = (SystemToolkit::cpu_time() - cpu_start) / wall;
+        }
+    }
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+
+    gst_object_unref (parse);
+    gst_object_unref (dec);
+    gst_object_unref (sink);
+    gst_object_unref (pipeline);
+
+    return result;
+}
+
+map<string, list<string> > GstToolkit::rank_decoders(list<string> uris, atomic<float> *progress)
+{
+    map<string, list<string> > ranking;
+
+    // one media for each codec
+    map<string, string> codec_uri;
+    map<string, string> codec_caps;
+    for (auto it = uris.begin(); it != uris.end(); ++it) {
+        string caps = video_stream_caps(*it);
+        string name = caps.substr(0, caps.find(','));
+        if ( !name.empty() && codec_uri.count(name) < 1 ) {
+            codec_uri[name] = *it;
+            codec_caps[name] = caps;
+        }
+    }
+
+    // decoders to benchmark
+    map<string, list<string> > codec_decoders;
+    size_t total = 0, done = 0;
+    for (auto it = codec_caps.begin(); it != codec_caps.end(); ++it) {
+        codec_decoders[it->first] = video_decoders(it->second);
+        total += codec_decoders[it->first].size();
+    }
+
+    for (auto it = codec_decoders.begin(); it != codec_decoders.end(); ++it) {
+
+        // real-time framerate of the media (25 fps if unknown)
+        double framerate = 25.0;
+        GstCaps *c = gst_caps_from_string (codec_caps[it->first].c_str());
+        if (c) {
+            gint n = 0, d = 1;
+            if ( gst_caps_get_size (c) > 0 &&
+                 gst_structure_get_fraction (gst_caps_get_structure (c, 0), "framerate", &n, &d) && n > 0 && d > 0 )
+                framerate = static_cast<double>(n) / static_cast<double>(d);
+            gst_caps_unref (c);
+        }
+
+        list<decoder_benchmark> results;
+        for (auto d = it->second.begin(); d != it->second.end(); ++d) {
+            decoder_benchmark r = benchmark_decoder(codec_uri[it->first], *d);
+            if (r.fps > 0.0) {
+                results.push_back(r);
+                Log::Info("Decoder %s for %s: %.1f fps, %.0f%% cpu", d->c_str(), it->first.c_str(), r.fps, r.cpu * 100.0);
+            }
+            if (progress)
+                *progress = static_cast<float>(++done) / static_cast<float>(total);
+        }
+
+        // decoders faster than real-time first, using less processor,
+        // then the others by speed
+        results.sort([framerate](const decoder_benchmark &a, const decoder_benchmark &b) {
+            bool ra = a.fps >= framerate, rb = b.fps >= framerate;
+            if (ra != rb)
+                return ra;
+            if (ra)
+                return a.fps / MAX(a.cpu, 0.05) > b.fps / MAX(b.cpu, 0.05);
+            return a.fps > b.fps;
+        });
+
+        for (auto r = results.begin(); r != results.end(); ++r)
+            ranking[it->first].push_back(r->decoder);
+    }
+
+    if (progress)
+        *progress = 1.f;
+
+    return ranking;
+}
+
+void GstToolkit::apply_decoders_ranking(const map<string, list<string> > &ranking)
+{
+    for (auto it = ranking.begin(); it != ranking.end(); ++it) {
+        guint rank = GST_RANK_PRIMARY + static_cast<guint>(it->second.size());
+        for (auto d = it->second.begin(); d != it->second.end(); ++d)
+            set_feature_rank(*d, rank--);
+    }
+}
+
 string GstToolkit::gst_version()
 {
     std::ostringstream oss;
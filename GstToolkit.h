@@ -5,6 +5,8 @@
 
 #include <string>
 #include <list>
+#include <map>
+#include <atomic>
 
 namespace GstToolkit
 {
@@ -22,6 +24,28 @@ std::list<std::string> all_plugins();
 std::list<std::string> all_plugin_features(std::string pluginname);
 
 bool enable_feature (std::string name, bool enable);
+bool set_feature_rank (std::string name, guint rank);
+
+// caps of the (encoded) video stream of a media, empty if none
+std::string video_stream_caps(const std::string &uri);
+// names of the video decoders accepting the caps, by decreasing rank (marginal or above)
+std::list<std::string> video_decoders(const std::string &caps);
+
+typedef struct {
+    std::string decoder;
+    double fps;  // frames decoded per second
+    double cpu;  // processor load (1.0 for one core)
+} decoder_benchmark;
+
+// decode a media with a given decoder, as fast as possible during a few seconds
+decoder_benchmark benchmark_decoder(const std::string &uri, const std::string &decoder, double seconds = 3.0);
+
+// benchmark all decoders for the codecs of the given media,
+// and return the decoders of each codec (caps name) from best to worst
+std::map<std::string, std::list<std::string> > rank_decoders(std::list<std::string> uris, std::atomic<float> *progress);
+// give decreasing ranks to the decoders of each codec (above primary)
+void apply_decoders_ranking(const std::map<std::string, std::list<std::string> > &ranking);
+
 
 }
 
@@ -279,6 +279,7 @@ void ImGuiToolkit::HelpMarker(const char* desc)
 // 1) a cursor at position *time in the range [0 duration]
 // 2) a line of tick marks indicating time, every step if possible
 // 3) a slider handle below the cursor: user can move the slider
+// 4) optionally, a mark at the given times (e.g. key frames)
 // Behavior
 // a) Returns TRUE if the left mouse button LMB is pressed over the timeline
 // b) the value of *time is changed to the position of the slider handle from user input (LMB)
@@ -286,7 +287,8 @@ void ImGuiToolkit::HelpMarker(const char* desc)
 #define NUM_MARKS 10
 #define LARGE_TICK_INCREMENT 1
 #define LABEL_TICK_INCREMENT 3
-bool ImGuiToolkit::TimelineSlider(const char* label, guint64 *time, guint64 duration, guint64 step, const float width)
+bool ImGuiToolkit::TimelineSlider(const char* label, guint64 *time, guint64 duration, guint64 step, const float width,
+                                  const std::vector<guint64> *marks)
 {
     static guint64 optimal_tick_marks[NUM_MARKS + LABEL_TICK_INCREMENT] = { 100 * MILISECOND, 500 * MILISECOND, 1 * SECOND, 2 * SECOND, 5 * SECOND, 10 * SECOND, 20 * SECOND, 1 * MINUTE, 2 * MINUTE, 5 * MINUTE, 10 * MINUTE, 60 * MINUTE, 60 * MINUTE };
 
@@ -447,6 +449,20 @@ bool ImGuiToolkit::TimelineSlider(const char* label, guint64 *time, guint64 dura
     // tick EOF
     window->DrawList->AddLine( timeline_bbox.GetTR(), timeline_bbox.GetTR() + ImVec2(0.f, fontsize), color);
 
+    // render marks at the bottom of TIMELINE (at most one per pixel)
+    if (marks != nullptr && duration > 0) {
+        ImU32 mark_color = ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+        float previous_x = -1.f;
+        for (auto m = marks->begin(); m != marks->end(); ++m) {
+            float mark_percent = static_cast<float> ( static_cast<double>(*m) / static_cast<double>(duration) );
+            pos = ImLerp(timeline_bbox.GetBL(), timeline_bbox.GetBR(), CLAMP(mark_percent, 0.f, 1.f));
+            if (pos.x - previous_x < 1.f)
+                continue;
+            window->DrawList->AddLine( pos, pos - ImVec2(0.f, style.FramePadding.y), mark_color);
+            previous_x = pos.x;
+        }
+    }
+
 // disabled: render position
 //    ImFormatString(overlay_buf, IM_ARRAYSIZE(overlay_buf), "%s", GstToolkit::time_to_string(*time).c_str());
 //    overlay_size = ImGui::CalcTextSize(overlay_buf, NULL);
@@ -27,7 +27,8 @@ namespace ImGuiToolkit
 
     // utility sliders
     void Bar (float value, float in, float out, float min, float max, const char* title, bool expand);
-    bool TimelineSlider (const char* label, guint64 *time, guint64 duration, guint64 step, const float width);
+    bool TimelineSlider (const char* label, guint64 *time, guint64 duration, guint64 step, const float width,
+                         const std::vector<guint64> *marks = nullptr);
     bool InvisibleSliderInt(const char* label, uint *index, int min, int max, const ImVec2 size);
 
     // fonts from ressources 'fonts/'
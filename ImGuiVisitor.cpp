@@ -15,6 +15,8 @@
 #include "ImageProcessingShader.h"
 #include "MediaPlayer.h"
 #include "MediaSource.h"
+#include "ImageSource.h"
+#include "SequenceSource.h"
 #include "SessionSource.h"
 #include "Settings.h"
 #include "Mixer.h"
@@ -309,10 +311,64 @@ void ImGuiVisitor::visit (MediaSource& s)
         if ( ImGui::Button(IMGUI_TITLE_MEDIAPLAYER, ImVec2(IMGUI_RIGHT_ALIGN, 0)) ) {
             UserInterface::manager().showMediaPlayer( s.mediaplayer());
         }
+        // deinterlacing on GPU
+        if ( s.mediaplayer()->isInterlaced() ) {
+            int mode = (int) s.mediaplayer()->deinterlace();
+            ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+            if ( ImGui::Combo("Deinterlace", &mode, VideoShader::deinterlace_name, IM_ARRAYSIZE(VideoShader::deinterlace_name)) )
+                s.mediaplayer()->setDeinterlace( (VideoShader::Deinterlace) mode );
+        }
     }
     ImGuiToolkit::ButtonOpenUrl( SystemToolkit::path_filename(s.path()).c_str(), ImVec2(IMGUI_RIGHT_ALIGN, 0) );
 }
 
+void ImGuiVisitor::visit (ImageSource& s)
+{
+    ImGuiToolkit::Icon(2,9);
+    ImGui::SameLine(0, 10);
+    ImGui::Text("Image File");
+    ImGui::Text("%d x %d", s.width(), s.height());
+    ImGuiToolkit::ButtonOpenUrl( SystemToolkit::path_filename(s.path()).c_str(), ImVec2(IMGUI_RIGHT_ALIGN, 0) );
+}
+
+void ImGuiVisitor::visit (SequenceSource& s)
+{
+    ImGuiToolkit::Icon(18,13);
+    ImGui::SameLine(0, 10);
+    ImGui::Text("Image sequence");
+    ImGui::Text("%d frames %d x %d (%d prefetched)", (int) s.numFrames(), s.width(), s.height(), (int) s.numPrefetched());
+
+    // play controls
+    if (ImGui::Button(s.playSpeed() > 0 ? ICON_FA_FAST_BACKWARD :ICON_FA_FAST_FORWARD))
+        s.rewind();
+    ImGui::SameLine(0, 10);
+    if (ImGui::Button(s.isPlaying() ? ICON_FA_PAUSE : ICON_FA_PLAY))
+        s.play( !s.isPlaying() );
+    ImGui::SameLine(0, 10);
+    static std::vector< std::pair<int, int> > iconsloop = { {1,15}, {0,15} };
+    int loop = s.loop() ? 0 : 1;
+    if ( ImGuiToolkit::ButtonIconMultistate(iconsloop, &loop) )
+        s.setLoop( loop == 0 );
+    ImGui::SameLine(0, 10);
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x IMGUI_RIGHT_ALIGN);
+    float speed = static_cast<float>(s.playSpeed());
+    if (ImGui::DragFloat("##Speed", &speed, 0.01f, -10.f, 10.f, "Speed x %.1f", 2.f))
+        s.setPlaySpeed( static_cast<double>(speed) );
+
+    // frame position
+    int frame = static_cast<int>( s.position() / s.timeline()->step() );
+    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+    if (ImGui::SliderInt("Frame", &frame, 0, MAX((int) s.numFrames() - 1, 0)))
+        s.seek( frame * s.timeline()->step() );
+
+    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+    float fps = static_cast<float>(s.framerate());
+    if (ImGui::DragFloat("Framerate", &fps, 0.1f, 1.f, 120.f, "%.1f fps"))
+        s.setFramerate(fps);
+
+    ImGuiToolkit::ButtonOpenUrl( SystemToolkit::base_filename(s.path()).c_str(), ImVec2(IMGUI_RIGHT_ALIGN, 0) );
+}
+
 void ImGuiVisitor::visit (SessionSource& s)
 {
     ImGuiToolkit::Icon(4,9);
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "ImageSource.h"
+
+#include "defines.h"
+#include "ImageShader.h"
+#include "ImageProcessingShader.h"
+#include "FrameBuffer.h"
+#include "Resource.h"
+#include "Primitives.h"
+#include "Decorations.h"
+#include "SystemToolkit.h"
+#include "Visitor.h"
+#include "Log.h"
+
+#define IMAGE_LOADER_THREADS 2
+
+// a few threads decoding the images of all image sources, in order of request
+static class ImageLoader {
+
+    std::deque< std::packaged_task<ImageSource::Image()> > tasks_;
+    std::vector<std::thread> threads_;
+    std::mutex lock_;
+    std::condition_variable condition_;
+    bool stop_;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            // when stopped, finish the tasks requested (every future gets its image)
+            if (tasks_.empty())
+                break;
+            std::packaged_task<ImageSource::Image()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+public:
+    ImageLoader() : stop_(false) {}
+
+    ~ImageLoader() {
+        lock_.lock();
+        stop_ = true;
+        lock_.unlock();
+        condition_.notify_all();
+        for (auto it = threads_.begin(); it != threads_.end(); ++it)
+            it->join();
+    }
+
+    std::future<ImageSource::Image> load(const std::string &filename, std::shared_ptr< std::atomic<bool> > cancel) {
+        std::packaged_task<ImageSource::Image()> task( [filename, cancel] () {
+            // not needed anymore
+            if ( cancel->load() )
+                return ImageSource::Image();
+            return ImageSource::loadImage(filename);
+        });
+        std::future<ImageSource::Image> f = task.get_future();
+
+        std::lock_guard<std::mutex> lock(lock_);
+        tasks_.push_back( std::move(task) );
+        // threads are created on first use
+        if ( threads_.empty() ) {
+            for (int i = 0; i < IMAGE_LOADER_THREADS; ++i)
+                threads_.push_back( std::thread(&ImageLoader::work, this) );
+        }
+        condition_.notify_one();
+
+        return f;
+    }
+
+} image_loader_;
+
+ImageSource::ImageSource() : Source(), path_(""), textureindex_(0), width_(0), height_(0)
+{
+    failed_ = false;
+    cancel_ = std::make_shared< std::atomic<bool> >(false);
+
+    // create image surface:
+    // - textured with the texture of the image
+    // - crop & repeat UV can be managed here
+    // - additional custom shader can be associated
+    imagesurface_ = new Surface(renderingshader_);
+}
+
+ImageSource::~ImageSource()
+{
+    // delete image surface
+    delete imagesurface_;
+
+    // delete texture
+    if (textureindex_)
+        glDeleteTextures(1, &textureindex_);
+
+    // free pixels if the image was loaded but never uploaded
+    // (not loaded at all if still waiting for a loader thread)
+    if ( imageLoader_.valid() ) {
+        *cancel_ = true;
+        Image img = imageLoader_.get();
+        if (img.pixels)
+            stbi_image_free(img.pixels);
+    }
+}
+
+bool ImageSource::supported(const std::string &p)
+{
+    std::string ext = SystemToolkit::extension_filename(p);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    // formats decoded by stb_image
+    return ( ext == "jpg" || ext == "jpeg" || ext == "png" || ext == "bmp" || ext == "tga" || ext == "psd" );
+}
+
+ImageSource::Image ImageSource::loadImage(const std::string &filename)
+{
+    Image img;
+    int n = 0;
+
+    // decode image in RGBA
+    img.pixels = stbi_load(filename.c_str(), &img.width, &img.height, &n, 4);
+    if (img.pixels == nullptr)
+        Log::Warning("Failed to open image %s: %s", filename.c_str(), stbi_failure_reason() );
+
+    return img;
+}
+
+void ImageSource::setPath(const std::string &p)
+{
+    path_ = p;
+
+    // decode the image file in a loader thread
+    imageLoader_ = image_loader_.load(path_, cancel_);
+
+    Log::Notify("Opening %s", p.c_str());
+}
+
+std::string ImageSource::path() const
+{
+    return path_;
+}
+
+uint ImageSource::width() const
+{
+    return width_;
+}
+
+uint ImageSource::height() const
+{
+    return height_;
+}
+
+bool ImageSource::failed() const
+{
+    return failed_;
+}
+
+uint ImageSource::texture() const
+{
+    if (textureindex_ == 0)
+        return Resource::getTextureBlack();
+    return textureindex_;
+}
+
+void ImageSource::replaceRenderingShader()
+{
+    imagesurface_->replaceShader(renderingshader_);
+}
+
+void ImageSource::init()
+{
+    // wait for the loader to decode the image
+    if ( !imageLoader_.valid() || imageLoader_.wait_for(std::chrono::milliseconds(4)) != std::future_status::ready )
+        return;
+
+    Image img = imageLoader_.get();
+    if (img.pixels == nullptr || img.width < 1 || img.height < 1) {
+        failed_ = true;
+        return;
+    }
+    width_ = img.width;
+    height_ = img.height;
+
+    // upload once (drawn 1:1 in the frame buffer of the source: no mipmap)
+    glGenTextures(1, &textureindex_);
+    glBindTexture(GL_TEXTURE_2D, textureindex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, img.width, img.height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, img.width, img.height, GL_RGBA, GL_UNSIGNED_BYTE, img.pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // free memory
+    stbi_image_free(img.pixels);
+
+    // apply the texture to the image surface
+    imagesurface_->setTextureIndex( textureindex_ );
+
+    // create Frame buffer matching size of image
+    FrameBuffer *renderbuffer = new FrameBuffer(width_, height_, true);
+
+    // set the renderbuffer of the source and attach rendering nodes
+    attach(renderbuffer);
+
+    // icon in mixing view
+    overlays_[View::MIXING]->attach( new Symbol(Symbol::IMAGE, glm::vec3(0.8f, 0.8f, 0.01f)) );
+    overlays_[View::LAYER]->attach( new Symbol(Symbol::IMAGE, glm::vec3(0.8f, 0.8f, 0.01f)) );
+
+    // done init
+    initialized_ = true;
+    Log::Info("Source Image linked to %s.", path_.c_str());
+
+    // force update of activation mode
+    active_ = true;
+    touch();
+}
+
+void ImageSource::render()
+{
+    if (!initialized_)
+        init();
+    else {
+        // render the image into frame buffer
+        static glm::mat4 projection = glm::ortho(-1.f, 1.f, 1.f, -1.f, -1.f, 1.f);
+        renderbuffer_->begin();
+        imagesurface_->draw(glm::identity<glm::mat4>(), projection);
+        renderbuffer_->end();
+    }
+}
+
+void ImageSource::accept(Visitor& v)
+{
+    Source::accept(v);
+    v.visit(*this);
+}
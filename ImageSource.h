@@ -0,0 +1,55 @@
+#ifndef IMAGESOURCE_H
+#define IMAGESOURCE_H
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include "Source.h"
+
+class ImageSource : public Source
+{
+public:
+    ImageSource();
+    ~ImageSource();
+
+    // implementation of source API
+    void render() override;
+    bool failed() const override;
+    uint texture() const override;
+    void accept (Visitor& v) override;
+
+    // Image specific interface
+    void setPath(const std::string &p);
+    std::string path() const;
+    uint width() const;
+    uint height() const;
+
+    // true if the file can be loaded by an ImageSource
+    static bool supported(const std::string &p);
+
+    // decoded pixels of an image (RGBA)
+    struct Image {
+        unsigned char *pixels;
+        int width;
+        int height;
+        Image() : pixels(nullptr), width(0), height(0) {}
+    };
+    // decode an image file (blocking; pixels to free with stbi_image_free)
+    static Image loadImage(const std::string &filename);
+
+protected:
+
+    void init() override;
+    void replaceRenderingShader() override;
+
+    Surface *imagesurface_;
+    std::string path_;
+    uint textureindex_;
+    uint width_, height_;
+
+    std::atomic<bool> failed_;
+    std::future<Image> imageLoader_;
+    std::shared_ptr< std::atomic<bool> > cancel_;
+};
+
+#endif // IMAGESOURCE_H
@@ -1,10 +1,20 @@
 #include <thread>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
 
 using namespace std;
 
 //  Desktop OpenGL function loader
 #include <glad/glad.h>
 
+// GStreamer OpenGL memory
+#include <gst/gl/gl.h>
+
+// cache of media information
+#include <tinyxml2.h>
+#include "tinyxml2Toolkit.h"
+
 
 // vmix
 #include "defines.h"
@@ -12,6 +22,12 @@ using namespace std;
 #include "Resource.h"
 #include "Visitor.h"
 #include "SystemToolkit.h"
+#include "Settings.h"
+#include "RenderingManager.h"
+#include "FrameBuffer.h"
+#include "Primitives.h"
+#include "VideoShader.h"
+#include "Recorder.h"
 
 #include "MediaPlayer.h"
 
@@ -22,6 +38,18 @@ using namespace std;
 #define USE_GST_APPSINK_CALLBACKS
 
 std::list<MediaPlayer*> MediaPlayer::registered_;
+std::mutex MediaPlayer::registry_lock_;
+std::thread MediaPlayer::upload_thread_;
+std::atomic<bool> MediaPlayer::upload_stop_(false);
+std::mutex MediaPlayer::upload_wait_;
+std::condition_variable MediaPlayer::upload_condition_;
+MediaPlayer::CachePool MediaPlayer::frame_cache_pool_;
+MediaPlayer::CachePool MediaPlayer::clip_cache_pool_;
+
+// stop the upload thread at exit, before the static members it uses are destroyed
+static struct UploadThreadOwner {
+    ~UploadThreadOwner() { MediaPlayer::terminate(); }
+} upload_thread_owner_;
 
 MediaPlayer::MediaPlayer(string name) : id_(name)
 {
@@ -29,29 +57,88 @@ MediaPlayer::MediaPlayer(string name) : id_(name)
         id_ = SystemToolkit::date_time_string();
 
     uri_ = "undefined";
+    index_cancel_ = false;
+    proxy_cancel_ = false;
+    proxy_progress_ = -1.f;
+    proxy_ready_ = false;
+    resume_position_ = GST_CLOCK_TIME_NONE;
+    resuming_ = false;
+    hibernated_ = false;
+    disabled_since_ = 0;
+    deinterlace_ = VideoShader::DEINTERLACE_ADAPTIVE;
+    field_tff_ = true;
+    field_second_ = false;
+    field_time_ = 0;
+    previous_plane_ = 0;
+    previous_valid_ = false;
+    proxy_width_ = proxy_height_ = 0;
+    threads_ = 1;
+    decode_start_ = GST_CLOCK_TIME_NONE;
+    decode_time_ = 0.f;
     pipeline_ = nullptr;
+    v_frame_caps_ = nullptr;
 
     ready_ = false;
     failed_ = false;
     seeking_ = false;
+    segment_loop_ = false;
     enabled_ = true;
+    warm_ = false;
+    scalable_ = false;
+    lod_ = 0;
+    use_gl_memory_ = true;
+    gl_buffer_ = nullptr;
     rate_ = 1.0;
     position_ = GST_CLOCK_TIME_NONE;
     desired_state_ = GST_STATE_PAUSED;
+    pipeline_state_ = GST_STATE_NULL;
     loop_ = LoopMode::LOOP_REWIND;
 
-    // start index in frame_ stack
+    // empty frame queue
     write_index_ = 0;
-    last_index_ = 0;
+    read_index_ = 0;
+    eos_ = false;
+    dropped_frames_ = 0;
+    queue_occupancy_ = 0.f;
+
+    // no reverse playback from cache
+    frame_cache_.pool = &frame_cache_pool_;
+    cache_reverse_ = false;
+    cache_filling_ = false;
+    cache_position_ = GST_CLOCK_TIME_NONE;
+    cache_time_ = 0;
+    scrub_pending_ = false;
+
+    // no clip cache by default
+    clip_cache_.pool = &clip_cache_pool_;
+    clip_budget_ = 0;
+    clip_enabled_ = false;
+    clip_filling_ = false;
+    clip_overflow_ = false;
+    clip_resident_ = false;
+    clip_position_ = GST_CLOCK_TIME_NONE;
+    clip_time_ = 0;
+    clip_hits_ = 0;
+    clip_misses_ = 0;
 
     // no PBO by default
     pbo_[0] = pbo_[1] = 0;
     pbo_size_ = 0;
     pbo_index_ = 0;
     pbo_next_index_ = 0;
+    pbo_map_ = nullptr;
+    for (guint i = 0; i < N_PBO_RING; ++i)
+        pbo_fence_[i] = nullptr;
+    pbo_sequence_ = 0;
+    worker_upload_ = false;
+    upload_refs_ = 0;
 
     // OpenGL texture
     textureindex_ = 0;
+    n_planes_ = 0;
+    yuv_buffer_ = nullptr;
+    yuv_surface_ = nullptr;
+    yuv_shader_ = nullptr;
 }
 
 MediaPlayer::~MediaPlayer()
@@ -71,7 +158,115 @@ guint MediaPlayer::texture() const
     return textureindex_;
 }
 
-static MediaInfo UriDiscoverer_(std::string uri)
+// files in cache are named after the signature of media files
+static bool IsCacheFile_(const std::string &filename)
+{
+    std::string base = SystemToolkit::base_filename(filename);
+    return base.size() == 24 && base.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+// remove the oldest files of information and index of media
+// while their size exceeds the budget of the cache
+static void TrimCache_()
+{
+    static std::mutex trim_lock;
+    std::lock_guard<std::mutex> lock(trim_lock);
+
+    const long budget = static_cast<long>( MAX(Settings::application.media.info_cache_budget, 0) ) * 1048576;
+    if ( budget == 0 )
+        return;
+
+    std::vector< std::pair<long, std::string> > files;
+    long total = 0;
+    std::list<std::string> ls = SystemToolkit::list_directory(SystemToolkit::cache_path(), "xml");
+    ls.splice(ls.end(), SystemToolkit::list_directory(SystemToolkit::cache_path(), "idx"));
+    for (auto it = ls.begin(); it != ls.end(); ++it) {
+        if ( IsCacheFile_(*it) ) {
+            files.push_back( std::make_pair(SystemToolkit::file_time(*it), *it) );
+            total += SystemToolkit::file_size(*it);
+        }
+    }
+
+    // oldest first
+    std::sort(files.begin(), files.end());
+    for (auto it = files.begin(); it != files.end() && total > budget; ++it) {
+        long size = SystemToolkit::file_size(it->second);
+        if ( std::remove(it->second.c_str()) == 0 )
+            total -= size;
+    }
+}
+
+// file of information on a media, named after the signature of the media file
+// (empty string if the file does not exist)
+static std::string MediaInfoFilename_(const std::string &filename)
+{
+    std::string signature = SystemToolkit::file_signature(filename);
+    if ( signature.empty() )
+        return signature;
+
+    return SystemToolkit::full_filename(SystemToolkit::cache_path(), signature + ".xml");
+}
+
+static bool ReadMediaInfo_(const std::string &infofile, MediaInfo &info)
+{
+    tinyxml2::XMLDocument xmlDoc;
+    if ( infofile.empty() || xmlDoc.LoadFile(infofile.c_str()) != tinyxml2::XML_SUCCESS )
+        return false;
+
+    tinyxml2::XMLElement *node = xmlDoc.FirstChildElement("MediaInfo");
+    if ( node == nullptr )
+        return false;
+
+    uint64_t end = GST_CLOCK_TIME_NONE;
+    uint64_t step = GST_CLOCK_TIME_NONE;
+    node->QueryUnsignedAttribute("width", &info.width);
+    node->QueryUnsignedAttribute("par_width", &info.par_width);
+    node->QueryUnsignedAttribute("height", &info.height);
+    node->QueryUnsignedAttribute("bitrate", &info.bitrate);
+    node->QueryDoubleAttribute("framerate", &info.framerate);
+    node->QueryBoolAttribute("isimage", &info.isimage);
+    node->QueryBoolAttribute("interlaced", &info.interlaced);
+    node->QueryBoolAttribute("seekable", &info.seekable);
+    node->QueryUnsigned64Attribute("end", &end);
+    node->QueryUnsigned64Attribute("step", &step);
+    const char *codec = node->Attribute("codec");
+    if (codec)
+        info.codec_name = std::string(codec);
+
+    if ( !info.isimage ) {
+        info.timeline.setEnd(end);
+        info.timeline.setStep(step);
+    }
+    info.valid = true;
+
+    return true;
+}
+
+static void WriteMediaInfo_(const std::string &infofile, const MediaInfo &info)
+{
+    tinyxml2::XMLDocument xmlDoc;
+    tinyxml2::XMLElement *node = xmlDoc.NewElement("MediaInfo");
+    xmlDoc.InsertEndChild(node);
+
+    node->SetAttribute("width", info.width);
+    node->SetAttribute("par_width", info.par_width);
+    node->SetAttribute("height", info.height);
+    node->SetAttribute("bitrate", info.bitrate);
+    node->SetAttribute("framerate", info.framerate);
+    node->SetAttribute("isimage", info.isimage);
+    node->SetAttribute("interlaced", info.interlaced);
+    node->SetAttribute("seekable", info.seekable);
+    node->SetAttribute("end", (uint64_t) info.timeline.end());
+    node->SetAttribute("step", (uint64_t) info.timeline.step());
+    node->SetAttribute("codec", info.codec_name.c_str());
+
+    if ( !tinyxml2::XMLSaveDoc(&xmlDoc, infofile) )
+        Log::Warning("MediaPlayer Could not write media information file '%s'", infofile.c_str());
+    else
+        TrimCache_();
+}
+
+static MediaInfo UriDiscoverer_(std::string uri, std::string infofile)
 {
 #ifdef MEDIA_PLAYER_DEBUG
     Log::Info("Checking '%s'", uri.c_str());
@@ -176,11 +371,371 @@ static MediaInfo UriDiscoverer_(std::string uri)
         g_object_unref (discoverer);
     }
 
+    // keep information in cache for next time
+    if ( video_stream_info.valid && !infofile.empty() )
+        WriteMediaInfo_(infofile, video_stream_info);
 
     // return the info
     return video_stream_info;
 }
 
+#define INDEX_FILE_MAGIC "VIMIXIDX1"
+
+static bool ReadIndex_(const std::string &indexfile, FrameIndex &index)
+{
+    std::ifstream file(indexfile, std::ios::binary);
+    if ( !file.is_open() )
+        return false;
+
+    char magic[sizeof(INDEX_FILE_MAGIC)] = {};
+    guint64 count = 0;
+    file.read(magic, sizeof(INDEX_FILE_MAGIC));
+    file.read((char *) &count, sizeof(count));
+    if ( !file.good() || std::string(magic) != INDEX_FILE_MAGIC || count > G_MAXINT32 )
+        return false;
+
+    index.resize(count);
+    for (guint64 i = 0; i < count && file.good(); ++i) {
+        guint8 key = 0;
+        file.read((char *) &index[i].pts, sizeof(index[i].pts));
+        file.read((char *) &index[i].offset, sizeof(index[i].offset));
+        file.read((char *) &key, sizeof(key));
+        index[i].keyframe = key > 0;
+    }
+
+    if ( !file.good() ) {
+        index.clear();
+        return false;
+    }
+    return true;
+}
+
+static void WriteIndex_(const std::string &indexfile, const FrameIndex &index)
+{
+    std::ofstream file(indexfile, std::ios::binary | std::ios::trunc);
+    if ( !file.is_open() ) {
+        Log::Warning("MediaPlayer Could not write index file '%s'", indexfile.c_str());
+        return;
+    }
+
+    guint64 count = index.size();
+    file.write(INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    file.write((const char *) &count, sizeof(count));
+    for (auto it = index.begin(); it != index.end(); ++it) {
+        guint8 key = it->keyframe ? 1 : 0;
+        file.write((const char *) &it->pts, sizeof(it->pts));
+        file.write((const char *) &it->offset, sizeof(it->offset));
+        file.write((const char *) &key, sizeof(key));
+    }
+    file.close();
+
+    TrimCache_();
+}
+
+// link the video stream of parsebin to the sink, others to fakesinks
+static void IndexerPadAdded_(GstElement *, GstPad *pad, gpointer p)
+{
+    GstElement *sink = (GstElement *) p;
+    GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+    GstCaps *caps = gst_pad_get_current_caps (pad);
+    if (caps == NULL)
+        caps = gst_pad_query_caps (pad, NULL);
+    const gchar *name = gst_caps_get_size (caps) > 0 ? gst_structure_get_name (gst_caps_get_structure (caps, 0)) : "";
+
+    if ( !gst_pad_is_linked (sinkpad) && ( g_str_has_prefix (name, "video/") || g_str_has_prefix (name, "image/") ) )
+        gst_pad_link (pad, sinkpad);
+    else {
+        GstElement *fake = gst_element_factory_make ("fakesink", NULL);
+        gst_bin_add (GST_BIN (GST_ELEMENT_PARENT (sink)), fake);
+        gst_element_sync_state_with_parent (fake);
+        GstPad *fakepad = gst_element_get_static_pad (fake, "sink");
+        gst_pad_link (pad, fakepad);
+        gst_object_unref (fakepad);
+    }
+
+    gst_caps_unref (caps);
+    gst_object_unref (sinkpad);
+}
+
+// a few indexings at a time, in background
+#define INDEXER_MAX_RUNNING 2
+static std::mutex IndexerLock_;
+static std::condition_variable IndexerCondition_;
+static int IndexerRunning_ = 0;
+
+static void IndexerRelease_()
+{
+    std::lock_guard<std::mutex> lock(IndexerLock_);
+    IndexerRunning_--;
+    IndexerCondition_.notify_one();
+}
+
+static FrameIndex UriIndexer_(std::string uri, std::string filename, std::atomic<bool> *cancel)
+{
+    FrameIndex index;
+
+    // index file in cache, named after the signature of the media file
+    std::string signature = SystemToolkit::file_signature(filename);
+    std::string indexfile;
+    if ( !signature.empty() ) {
+        indexfile = SystemToolkit::full_filename(SystemToolkit::cache_path(), signature + ".idx");
+        // already indexed
+        if ( ReadIndex_(indexfile, index) )
+            return index;
+    }
+
+    // wait for other indexings to finish
+    {
+        std::unique_lock<std::mutex> lock(IndexerLock_);
+        while ( IndexerRunning_ >= INDEXER_MAX_RUNNING ) {
+            if ( cancel->load() )
+                return index;
+            IndexerCondition_.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        IndexerRunning_++;
+    }
+
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("Indexing '%s'", uri.c_str());
+#endif
+
+    // demux and parse the stream without decoding
+    GError *error = NULL;
+    std::string description = "urisourcebin uri=" + uri + " ! parsebin name=parse";
+    GstElement *pipeline = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        Log::Warning("MediaPlayer Could not index '%s': %s", uri.c_str(), error->message);
+        g_clear_error (&error);
+        if (pipeline)
+            gst_object_unref (pipeline);
+        IndexerRelease_();
+        return index;
+    }
+
+    GstElement *sink = gst_element_factory_make ("appsink", "sink");
+    gst_bin_add (GST_BIN (pipeline), sink);
+    gst_base_sink_set_sync (GST_BASE_SINK(sink), false);
+    GstElement *parse = gst_bin_get_by_name (GST_BIN (pipeline), "parse");
+    g_signal_connect (G_OBJECT(parse), "pad-added", G_CALLBACK (IndexerPadAdded_), sink);
+    gst_object_unref (parse);
+
+    // read all the buffers of the video stream
+    bool complete = false;
+    if ( gst_element_set_state (pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE ) {
+        GstBus *bus = gst_element_get_bus (pipeline);
+        int timeout = 0;
+        while ( !cancel->load() && timeout < 10 ) {
+            GstSample *sample = gst_app_sink_try_pull_sample (GST_APP_SINK(sink), GST_SECOND);
+            if (sample == NULL) {
+                // end of stream: done
+                if ( gst_app_sink_is_eos (GST_APP_SINK(sink)) ) {
+                    complete = true;
+                    break;
+                }
+                // failed
+                GstMessage *msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+                if (msg) {
+                    gst_message_unref (msg);
+                    break;
+                }
+                timeout++;
+                continue;
+            }
+            GstBuffer *buf = gst_sample_get_buffer (sample);
+            FrameIndexEntry e;
+            e.pts = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : GST_BUFFER_DTS(buf);
+            e.offset = GST_BUFFER_OFFSET(buf);
+            e.keyframe = !GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT);
+            if ( GST_CLOCK_TIME_IS_VALID(e.pts) )
+                index.push_back(e);
+            gst_sample_unref (sample);
+            timeout = 0;
+        }
+        gst_object_unref (bus);
+    }
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+    IndexerRelease_();
+
+    // partial index is useless
+    if ( !complete ) {
+        index.clear();
+        return index;
+    }
+
+    // frames are demuxed in decoding order
+    std::sort(index.begin(), index.end());
+
+    // keep index in cache
+    if ( !indexfile.empty() && !index.empty() )
+        WriteIndex_(indexfile, index);
+
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("Indexed %ld frames in '%s'", index.size(), uri.c_str());
+#endif
+
+    return index;
+}
+
+// one transcoding at a time, in background
+static std::mutex TranscoderLock_;
+static std::atomic<int> TranscoderPending_(0);
+bool MediaPlayer::proxy_allowed_ = true;
+
+std::string MediaPlayer::proxyPath()
+{
+    // folder given in settings, or in the cache otherwise
+    std::string path = Settings::application.media.proxy_path;
+    if ( path.empty() || !SystemToolkit::file_exists(path) ) {
+        path = SystemToolkit::full_filename(SystemToolkit::cache_path(), "proxy");
+        if ( !SystemToolkit::file_exists(path) && !SystemToolkit::create_directory(path) )
+            path = SystemToolkit::cache_path();
+    }
+    return path;
+}
+
+int MediaPlayer::proxyPending()
+{
+    return TranscoderPending_;
+}
+
+void MediaPlayer::allowProxy(bool on)
+{
+    // media players switch in update
+    proxy_allowed_ = on;
+}
+
+static std::string ProxyFilename_(const std::string &filename, int profile, int height)
+{
+    std::string signature = SystemToolkit::file_signature(filename);
+    if (signature.empty())
+        return std::string();
+
+    // one proxy per encoding profile and resolution
+    std::string ext = profile == VideoRecorder::VP8 ? ".webm" : ".mov";
+    return SystemToolkit::full_filename(MediaPlayer::proxyPath(),
+                                        signature + "_" + std::to_string(profile) + "_" + std::to_string(height) + ext);
+}
+
+static void ProxySize_(const MediaInfo &media, int height, guint &w, guint &h)
+{
+    // square pixels, same display aspect ratio, even size
+    w = media.par_width & ~1;
+    h = media.height & ~1;
+    if (height > 0 && media.height > 0) {
+        h = static_cast<guint>(height) & ~1;
+        w = MAX( (media.par_width * h / media.height) & ~1, 16);
+    }
+}
+
+static bool UriTranscoder_(std::string uri, std::string proxyfile, int profile, guint width, guint height,
+                           bool interlaced, std::atomic<float> *progress, std::atomic<bool> *cancel)
+{
+    // transcoded before
+    if ( SystemToolkit::file_exists(proxyfile) ) {
+        *progress = 1.f;
+        return true;
+    }
+
+    // wait for other transcodings to finish
+    TranscoderPending_++;
+    while ( !TranscoderLock_.try_lock() ) {
+        if ( cancel->load() ) {
+            TranscoderPending_--;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    *progress = 0.f;
+
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("Transcoding '%s'", uri.c_str());
+#endif
+
+    // decode, scale down and encode the video stream with a profile of the recorder
+    // (written in a temporary file, renamed only when complete)
+    // NB: interlaced frames are deinterlaced before scaling, which would mix their fields
+    std::string partfile = proxyfile + ".part";
+    std::string description = "uridecodebin uri=" + uri + " name=decoder ";
+    description += "queue name=input ! ";
+    if (interlaced)
+        description += "deinterlace ! ";
+    description += "videoconvert ! videoscale ! ";
+    description += "video/x-raw, width=" + std::to_string(width) + ", height=" + std::to_string(height);
+    description += ", pixel-aspect-ratio=1/1 ! videoconvert ! ";
+    description += VideoRecorder::profile_description[profile];
+    description += profile == VideoRecorder::VP8 ? "webmmux ! " : "qtmux ! ";
+    description += "filesink location=\"" + partfile + "\"";
+
+    bool complete = false;
+    GError *error = NULL;
+    GstElement *pipeline = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        Log::Warning("MediaPlayer Could not transcode '%s': %s", uri.c_str(), error->message);
+        g_clear_error (&error);
+    }
+    else {
+        // only the video stream is transcoded
+        GstElement *decoder = gst_bin_get_by_name (GST_BIN (pipeline), "decoder");
+        GstElement *input = gst_bin_get_by_name (GST_BIN (pipeline), "input");
+        g_signal_connect (G_OBJECT(decoder), "pad-added", G_CALLBACK (IndexerPadAdded_), input);
+        gst_object_unref (decoder);
+        gst_object_unref (input);
+
+        if ( gst_element_set_state (pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE ) {
+            GstBus *bus = gst_element_get_bus (pipeline);
+            while ( !cancel->load() ) {
+                GstMessage *msg = gst_bus_timed_pop_filtered (bus, 200 * GST_MSECOND,
+                                                              (GstMessageType) (GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+                if (msg) {
+                    complete = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+                    if (!complete) {
+                        GError *err = NULL;
+                        gst_message_parse_error (msg, &err, NULL);
+                        Log::Warning("MediaPlayer Could not transcode '%s': %s", uri.c_str(), err ? err->message : "");
+                        g_clear_error (&err);
+                    }
+                    gst_message_unref (msg);
+                    break;
+                }
+                // progress
+                gint64 pos = 0, dur = 0;
+                if ( gst_element_query_position (pipeline, GST_FORMAT_TIME, &pos) &&
+                     gst_element_query_duration (pipeline, GST_FORMAT_TIME, &dur) && dur > 0 )
+                    *progress = static_cast<float>( static_cast<double>(pos) / static_cast<double>(dur) );
+            }
+            gst_object_unref (bus);
+        }
+        gst_element_set_state (pipeline, GST_STATE_NULL);
+    }
+    if (pipeline)
+        gst_object_unref (pipeline);
+
+    // keep the proxy only if complete
+    if ( complete && std::rename(partfile.c_str(), proxyfile.c_str()) == 0 ) {
+        *progress = 1.f;
+        Log::Info("Proxy of '%s' ready.", uri.c_str());
+    }
+    else {
+        complete = false;
+        std::remove(partfile.c_str());
+        *progress = -1.f;
+    }
+
+    TranscoderLock_.unlock();
+    TranscoderPending_--;
+    return complete;
+}
+
+// equal share of the global budget of decoding threads (all cores by default)
+static guint DecoderThreads_(guint decoding)
+{
+    guint budget = Settings::application.media.decoder_threads > 0 ?
+                (guint) Settings::application.media.decoder_threads : MAX(std::thread::hardware_concurrency(), 1u);
+    return decoding > 0 ? MAX(budget / decoding, 1u) : budget;
+}
+
 void MediaPlayer::open(string path)
 {
     // set path
@@ -193,9 +748,21 @@ void MediaPlayer::open(string path)
 
     // reset
     ready_ = false;
-
-    // start URI discovering thread:
-    discoverer_ = std::async( UriDiscoverer_, uri_);
+    proxy_.clear();
+    proxy_ready_ = false;
+    original_index_.clear();
+
+    // media discovered before and not modified since: information is ready
+    std::string infofile = MediaInfoFilename_(path);
+    MediaInfo info;
+    if ( ReadMediaInfo_(infofile, info) ) {
+        std::promise<MediaInfo> discovered;
+        discovered.set_value(info);
+        discoverer_ = discovered.get_future();
+    }
+    else
+        // start URI discovering thread:
+        discoverer_ = std::async( UriDiscoverer_, uri_, infofile);
 
     // wait for discoverer to finish in the future (test in update)
 }
@@ -213,10 +780,39 @@ void MediaPlayer::execute_open()
     //            Uses linear interpolation 1 (default)
     //            Uses cubic interpolation 2
     //            Uses sinc interpolation 3
-    string description = "uridecodebin uri=" + uri_ + " ! ";
-    if (media_.interlaced)
-        description += "deinterlace ! ";
-    description += "videoconvert chroma-resampler=2 ! appsink name=sink";
+    // Zero-copy: if gstreamer can share the OpenGL context, frames are decoded
+    // and converted in OpenGL memory and their textures are used directly
+    // (fallback to system memory if not available or cannot be negotiated)
+    // (interlaced frames are uploaded to be deinterlaced on GPU)
+    use_gl_memory_ = use_gl_memory_ && !media_.isimage && !media_.interlaced && Rendering::manager().glContextShared();
+    if (use_gl_memory_) {
+        GstElementFactory *factory = gst_element_factory_find ("glupload");
+        if (factory)
+            gst_object_unref (factory);
+        else
+            use_gl_memory_ = false;
+    }
+
+    // Adaptive resolution: frames are scaled down before upload if displayed small
+    // (the size of frames is changed with the caps of the sink ; scaling would mix fields)
+    scalable_ = Settings::application.media.adaptive_resolution && !media_.isimage && !media_.interlaced;
+    if (scalable_) {
+        GstElementFactory *factory = gst_element_factory_find (use_gl_memory_ ? "glcolorscale" : "videoscale");
+        if (factory)
+            gst_object_unref (factory);
+        else
+            scalable_ = false;
+    }
+    lod_ = 0;
+
+    // decode the proxy of the media if ready
+    string description = "uridecodebin uri=" + (proxy_.empty() ? uri_ : proxy_) + " ! ";
+    if (use_gl_memory_)
+        description += scalable_ ? "glupload ! glcolorconvert ! glcolorscale ! appsink name=sink" :
+                                   "glupload ! glcolorconvert ! appsink name=sink";
+    else
+        description += scalable_ ? "videoconvert chroma-resampler=2 ! videoscale ! appsink name=sink" :
+                                   "videoconvert chroma-resampler=2 ! appsink name=sink";
 
     // parse pipeline descriptor
     GError *error = NULL;
@@ -229,15 +825,48 @@ void MediaPlayer::execute_open()
     }
     g_object_set(G_OBJECT(pipeline_), "name", id_.c_str(), NULL);
 
-    // GstCaps *caps = gst_static_caps_get (&frame_render_caps);    
-    string capstring = "video/x-raw,format=RGBA,width="+ std::to_string(media_.width) +
-            ",height=" + std::to_string(media_.height);
-    GstCaps *caps = gst_caps_from_string(capstring.c_str());
-    if (!gst_video_info_from_caps (&v_frame_video_info_, caps)) {
+    // configure threads of elements created by the decodebin, and of those already in the pipeline
+    decode_start_ = GST_CLOCK_TIME_NONE;
+    decode_time_ = 0.f;
+    g_signal_connect(G_OBJECT(pipeline_), "deep-element-added", G_CALLBACK (callback_element_added), this);
+    GstIterator *it = gst_bin_iterate_recurse (GST_BIN (pipeline_));
+    GValue item = G_VALUE_INIT;
+    while ( gst_iterator_next (it, &item) == GST_ITERATOR_OK ) {
+        callback_element_added (GST_BIN (pipeline_), NULL, GST_ELEMENT (g_value_get_object (&item)), this);
+        g_value_reset (&item);
+    }
+    g_value_unset (&item);
+    gst_iterator_free (it);
+
+    // caps of frames at full resolution
+    GstCaps *caps = frame_caps();
+    if (!caps) {
         Log::Warning("MediaPlayer %s Could not configure video frame info", id_.c_str());
         failed_ = true;
         return;
     }
+    // actual video frame info is given by the caps of samples
+    gst_video_info_init (&v_frame_video_info_);
+
+    // allocate the queue of frames (one slot is always free)
+    guint queue_size = CLAMP(Settings::application.media.queue_depth, 1, MAX_VFRAME - 1) + 1;
+    frame_.assign(queue_size, Frame());
+    write_index_ = 0;
+    read_index_ = 0;
+    eos_ = false;
+    dropped_frames_ = 0;
+    queue_occupancy_ = 0.f;
+
+    // budget of the caches of decoded frames of all media players (not for frames in OpenGL memory)
+    frame_cache_.clear();
+    frame_cache_.budget = use_gl_memory_ || media_.isimage ? 0 :
+            static_cast<gsize>( MAX(Settings::application.media.cache_budget, 0) ) * 1048576;
+
+    // budget of the clip caches of all media players
+    // (frames are never evicted, the budget limits the first pass)
+    clip_cache_.clear();
+    clip_cache_.budget = G_MAXSIZE;
+    clip_budget_ = static_cast<gsize>( MAX(Settings::application.media.clip_cache_budget, 0) ) * 1048576;
 
     // setup appsink
     GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline_), "sink");
@@ -284,11 +913,24 @@ void MediaPlayer::execute_open()
     }
     gst_caps_unref (caps);
     
-    // capture bus signals to force a unique opengl context for all GST elements 
-    //Rendering::LinkPipeline(GST_PIPELINE (pipeline));
+    // capture bus signals to force a unique opengl context for all GST elements
+    if (use_gl_memory_)
+        Rendering::manager().LinkPipeline(GST_PIPELINE (pipeline_));
+
+    // decoders read their number of threads only when configured, after this state change:
+    // give the share this media player will have when decoding with the others
+    guint decoding = 1;
+    registry_lock_.lock();
+    for (auto it = registered_.begin(); it != registered_.end(); ++it)
+        if ( *it != this && (*it)->decoding() )
+            decoding++;
+    registry_lock_.unlock();
+    threads_ = DecoderThreads_(decoding);
 
     // set to desired state (PLAY or PAUSE)
-    GstStateChangeReturn ret = gst_element_set_state (pipeline_, desired_state_);
+    // (or pre-roll in pause when re-opened: the state is restored at the position to resume)
+    resuming_ = resume_position_ != GST_CLOCK_TIME_NONE;
+    GstStateChangeReturn ret = gst_element_set_state (pipeline_, resuming_ ? GST_STATE_PAUSED : desired_state_);
     if (ret == GST_STATE_CHANGE_FAILURE) {
         Log::Warning("MediaPlayer %s Could not open '%s'", id_.c_str(), uri_.c_str());
         failed_ = true;
@@ -307,8 +949,101 @@ void MediaPlayer::execute_open()
     Log::Info("MediaPlayer %s Opened '%s' (%s %d x %d)", id_.c_str(), uri_.c_str(), media_.codec_name.c_str(), media_.width, media_.height);
     ready_ = true;
 
+    // start transcoding a proxy in background (result is tested in update)
+    if ( proxy_wanted() ) {
+        proxy_file_ = ProxyFilename_(filename_, Settings::application.media.proxy_profile,
+                                     Settings::application.media.proxy_height);
+        if ( !proxy_file_.empty() ) {
+            ProxySize_(original_, Settings::application.media.proxy_height, proxy_width_, proxy_height_);
+            proxy_cancel_ = false;
+            transcoder_ = std::async(std::launch::async, UriTranscoder_, uri_, proxy_file_,
+                                     Settings::application.media.proxy_profile, proxy_width_, proxy_height_,
+                                     original_.interlaced, &proxy_progress_, &proxy_cancel_);
+        }
+    }
+
+    // start indexing frames of the original media in background (result is tested in update)
+    if ( media_.seekable && !media_.isimage && original_index_.empty() ) {
+        index_cancel_ = false;
+        indexer_ = std::async(std::launch::async, UriIndexer_, uri_, filename_, &index_cancel_);
+    }
+
     // register media player
+    registry_lock_.lock();
     MediaPlayer::registered_.push_back(this);
+    registry_lock_.unlock();
+
+    // start the upload thread once for all media players
+    if ( !upload_thread_.joinable() ) {
+        upload_stop_ = false;
+        upload_thread_ = std::thread(upload_worker);
+    }
+
+    // share decoding threads with this new media player
+    rebalance_threads();
+}
+
+GstCaps *MediaPlayer::frame_caps() const
+{
+    // size of frames at the current level of detail (even for YUV formats)
+    guint width = media_.width;
+    guint height = media_.height;
+    if (lod_ > 0) {
+        width = MAX( (width >> lod_) & ~1, 16);
+        height = MAX( (height >> lod_) & ~1, 16);
+    }
+    string size = ",width="+ std::to_string(width) + ",height=" + std::to_string(height);
+
+    // GstCaps *caps = gst_static_caps_get (&frame_render_caps);
+    // Videos can be uploaded in their native YUV format (no conversion by videoconvert
+    // if the decoder produces one of them) and converted to RGBA on GPU
+    string capstring = "video/x-raw,format=RGBA" + size;
+    if (use_gl_memory_)
+        capstring = "video/x-raw(memory:GLMemory),format=RGBA,texture-target=2D" + size;
+    else if (Settings::application.render.gpu_colorspace && !media_.isimage)
+        capstring = "video/x-raw,format=(string){I420,NV12,YUY2,RGBA}" + size;
+
+    return gst_caps_from_string(capstring.c_str());
+}
+
+void MediaPlayer::setDisplayHeight(guint h)
+{
+    if ( !ready_ || !scalable_ || h < 1 )
+        return;
+
+    // lowest level of detail still higher than the display
+    guint lod = 0;
+    while ( lod < MAX_LOD && (media_.height >> (lod + 1)) >= h )
+        ++lod;
+
+    // increase resolution immediately, but decrease only if clearly smaller
+    if ( lod > lod_ && (media_.height >> lod) < h + h / 4 )
+        --lod;
+    if ( lod == lod_ )
+        return;
+    lod_ = lod;
+
+    // change the caps of the sink and renegotiate
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline_), "sink");
+    GstCaps *caps = frame_caps();
+    if (sink && caps) {
+        gst_app_sink_set_caps (GST_APP_SINK(sink), caps);
+        GstPad *pad = gst_element_get_static_pad (sink, "sink");
+        gst_pad_push_event (pad, gst_event_new_reconfigure ());
+        gst_object_unref (pad);
+#ifdef MEDIA_PLAYER_DEBUG
+        Log::Info("MediaPlayer %s Decoding at 1/%d resolution.", id_.c_str(), 1 << lod_);
+#endif
+    }
+    if (caps)
+        gst_caps_unref (caps);
+    if (sink)
+        gst_object_unref (sink);
+}
+
+guint MediaPlayer::levelOfDetail() const
+{
+    return lod_;
 }
 
 bool MediaPlayer::isOpen() const
@@ -325,46 +1060,111 @@ void MediaPlayer::close()
 {
     // not openned?
     if (!ready_) {
-        // wait for loading to finish
-        discoverer_.wait();
+        // wait for loading to finish (if not hibernating)
+        if (discoverer_.valid())
+            discoverer_.wait();
         // nothing else to change
         return;
     }
 
-    // un-ready the media player
+    // stop indexing
+    if ( indexer_.valid() ) {
+        index_cancel_ = true;
+        indexer_.wait();
+        indexer_ = std::future<FrameIndex>();
+    }
+
+    // stop transcoding
+    if ( transcoder_.valid() ) {
+        proxy_cancel_ = true;
+        transcoder_.wait();
+        transcoder_ = std::future<bool>();
+        proxy_progress_ = -1.f;
+    }
+
+    // un-ready the media player and stop its uploads
+    upload_lock_.lock();
     ready_ = false;
+    worker_upload_ = false;
+    upload_lock_.unlock();
 
     // clean up GST
+    // NB: change to NULL state is synchronous (streaming threads are stopped on return)
     if (pipeline_ != nullptr) {
-        GstStateChangeReturn ret = gst_element_set_state (pipeline_, GST_STATE_NULL);
-        if (ret == GST_STATE_CHANGE_ASYNC) {
-            GstState state;
-            gst_element_get_state (pipeline_, &state, NULL, GST_CLOCK_TIME_NONE);
-        }
+        gst_element_set_state (pipeline_, GST_STATE_NULL);
         gst_object_unref (pipeline_);
         pipeline_ = nullptr;
     }
-
-    // cleanup eventual remaining frame memory
-    for(guint i = 0; i < N_VFRAME; i++){
+    pipeline_state_ = GST_STATE_NULL;
+    seeking_ = false;
+    segment_loop_ = false;
+    resuming_ = false;
+    cache_reverse_ = false;
+    cache_filling_ = false;
+    scrub_pending_ = false;
+    clip_filling_ = false;
+    clip_overflow_ = false;
+    clip_resident_ = false;
+
+    // cleanup eventual remaining frame memory (streaming thread is stopped)
+    for(guint i = 0; i < frame_.size(); i++){
         if ( frame_[i].full ) {
             gst_video_frame_unmap(&frame_[i].vframe);
+            frame_[i].full = false;
             frame_[i].status = INVALID;
         }
     }
-
-    // cleanup opengl texture
-    if (textureindex_)
-        glDeleteTextures(1, &textureindex_);
+    write_index_ = 0;
+    read_index_ = 0;
+    eos_ = false;
+
+    // free cached frames
+    frame_cache_.clear();
+    clip_cache_.clear();
+
+    // cleanup negotiated caps and OpenGL buffer
+    gst_caps_replace (&v_frame_caps_, NULL);
+    gst_buffer_replace (&gl_buffer_, NULL);
+
+    // cleanup opengl textures
+    if (n_planes_ > 0)
+        glDeleteTextures(n_planes_, planes_);
+    n_planes_ = 0;
+    if (previous_plane_)
+        glDeleteTextures(1, &previous_plane_);
+    previous_plane_ = 0;
     textureindex_ = 0;
 
+    // cleanup colorspace conversion
+    if (yuv_buffer_) {
+        delete yuv_surface_;
+        delete yuv_buffer_;
+        yuv_surface_ = nullptr;
+        yuv_buffer_ = nullptr;
+        yuv_shader_ = nullptr;
+    }
+
     // cleanup picture buffer
-    if (pbo_[0])
-        glDeleteBuffers(2, pbo_);
-    pbo_size_ = 0;
+    free_pbo();
 
     // unregister media player
+    registry_lock_.lock();
     MediaPlayer::registered_.remove(this);
+    registry_lock_.unlock();
+
+    // wait for the upload thread to release its reference
+    while ( upload_refs_.load() > 0 )
+        std::this_thread::yield();
+
+    // release elements of the pipeline
+    threaded_lock_.lock();
+    for (auto it = threaded_.begin(); it != threaded_.end(); ++it)
+        gst_object_unref (*it);
+    threaded_.clear();
+    threaded_lock_.unlock();
+
+    // give decoding threads of this media player to others
+    rebalance_threads();
 }
 
 
@@ -398,28 +1198,43 @@ GstClockTime MediaPlayer::position()
 
 void MediaPlayer::enable(bool on)
 {
+    // restore resources of a hibernating media player
+    if ( on && hibernated_ )
+        wake();
+
     if ( !ready_ )
         return;
 
     if ( enabled_ != on ) {
 
         enabled_ = on;
+        warm_ = false;
+        disabled_since_ = gst_util_get_timestamp ();
+
+        // frames of a disabled media player are not scrubbed:
+        // leave the budget of the cache to the others
+        if (!enabled_)
+            frame_cache_.clear();
 
         // default to pause
         GstState requested_state = GST_STATE_PAUSED;
 
-        // unpause only if enabled
-        if (enabled_) {
+        // unpause only if enabled (and not playing from the clip cache)
+        if (enabled_ && !clip_resident_) {
             requested_state = desired_state_;
         }
 
-        //  apply state change
-        GstStateChangeReturn ret = gst_element_set_state (pipeline_, requested_state);
-        if (ret == GST_STATE_CHANGE_FAILURE) {
-            Log::Warning("MediaPlayer %s Failed to enable", gst_element_get_name(pipeline_));
-            failed_ = true;
+        //  apply state change (once at the position to resume if re-opened)
+        if (!resuming_) {
+            GstStateChangeReturn ret = gst_element_set_state (pipeline_, requested_state);
+            if (ret == GST_STATE_CHANGE_FAILURE) {
+                Log::Warning("MediaPlayer %s Failed to enable", gst_element_get_name(pipeline_));
+                failed_ = true;
+            }
         }
 
+        // share decoding threads among enabled media players
+        rebalance_threads();
     }
 }
 
@@ -428,38 +1243,201 @@ bool MediaPlayer::isEnabled() const
     return enabled_;
 }
 
-bool MediaPlayer::isImage() const
+void MediaPlayer::warm(bool on)
 {
-    return media_.isimage;
+    // restore resources of a hibernating media player
+    if ( on && hibernated_ )
+        wake();
+
+    // only disabled media players are warmed
+    if ( !ready_ || enabled_ || warm_ == on )
+        return;
+
+    warm_ = on;
+
+    // run the pipeline as if enabled (unless playing from the clip cache)
+    GstState requested_state = GST_STATE_PAUSED;
+    if (warm_ && !clip_resident_)
+        requested_state = desired_state_;
+
+    if (!resuming_) {
+        GstStateChangeReturn ret = gst_element_set_state (pipeline_, requested_state);
+        if (ret == GST_STATE_CHANGE_FAILURE) {
+            Log::Warning("MediaPlayer %s Failed to pre-roll", gst_element_get_name(pipeline_));
+            failed_ = true;
+        }
+    }
+
+    // a warm media player decodes like an enabled one
+    rebalance_threads();
 }
 
-void MediaPlayer::play(bool on)
+bool MediaPlayer::isWarm() const
 {
-    // ignore if disabled, and cannot play an image
-    if (!enabled_ || media_.isimage)
+    return warm_;
+}
+
+void MediaPlayer::hibernate()
+{
+    // (not while transcoding a proxy in background)
+    if ( !ready_ || enabled_ || warm_ || hibernated_ || media_.isimage || transcoder_.valid() )
         return;
 
-    // request state 
-    GstState requested_state = on ? GST_STATE_PLAYING : GST_STATE_PAUSED;
+    // release everything; the position is kept to resume
+    GstClockTime pos = position_;
+    close();
+    hibernated_ = true;
+    resume_position_ = pos;
 
-    // ignore if requesting twice same state
-    if (desired_state_ == requested_state)
-        return;
+    Log::Info("MediaPlayer %s Hibernating", id_.c_str());
+}
 
-    // accept request to the desired state
-    desired_state_ = requested_state;
+bool MediaPlayer::isHibernating() const
+{
+    return hibernated_;
+}
 
-    // if not ready yet, the requested state will be handled later
-    if ( pipeline_ == nullptr )
-        return;
+bool MediaPlayer::isResuming() const
+{
+    return resuming_;
+}
 
-    // requesting to play, but stopped at end of stream : rewind first !
-    if ( desired_state_ == GST_STATE_PLAYING) {
-        if ( ( rate_>0.0 ? media_.timeline.end() - position() : position() ) < 2 * media_.timeline.step() )
-            rewind();
-    }
+void MediaPlayer::wake()
+{
+    hibernated_ = false;
 
-    // all ready, apply state change immediately
+    // decode the proxy or the original media, as allowed now
+    if (proxy_ready_ && proxy_.empty() == proxy_allowed_)
+        use_proxy(proxy_allowed_);
+
+    // open again: the pipeline pre-rolls in background
+    // and frames are shown from the position it had
+    execute_open();
+
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("MediaPlayer %s Resuming from hibernation", id_.c_str());
+#endif
+}
+
+void MediaPlayer::memoryUsage(gsize &ram, gsize &vram, gsize &cache)
+{
+    ram = vram = cache = 0;
+    std::lock_guard<std::mutex> lock(registry_lock_);
+    for (auto it = registered_.begin(); it != registered_.end(); ++it) {
+        gsize r = 0, v = 0;
+        (*it)->memory_usage(r, v);
+        ram += r;
+        vram += v;
+        cache += (*it)->frame_cache_.size() + (*it)->clip_cache_.size();
+    }
+}
+
+void MediaPlayer::manageResidency()
+{
+    GstClockTime now = gst_util_get_timestamp ();
+
+    const gsize ram_budget  = static_cast<gsize>( MAX(Settings::application.media.ram_budget, 0) ) * 1048576;
+    const gsize vram_budget = static_cast<gsize>( MAX(Settings::application.media.vram_budget, 0) ) * 1048576;
+    const GstClockTime delay = static_cast<GstClockTime>( MAX(Settings::application.media.hibernate_delay, 0) ) * GST_SECOND;
+    if ( ram_budget == 0 && vram_budget == 0 )
+        return;
+
+    // memory used, and media players disabled for long enough
+    gsize ram = 0, vram = 0;
+    std::vector<MediaPlayer *> idle;
+    registry_lock_.lock();
+    for (auto it = registered_.begin(); it != registered_.end(); ++it) {
+        gsize r = 0, v = 0;
+        (*it)->memory_usage(r, v);
+        ram += r;
+        vram += v;
+        if ( !(*it)->enabled_ && !(*it)->warm_ && !(*it)->media_.isimage && now - (*it)->disabled_since_ > delay )
+            idle.push_back(*it);
+    }
+    registry_lock_.unlock();
+
+    // least recently used first
+    std::sort(idle.begin(), idle.end(), [](const MediaPlayer *a, const MediaPlayer *b) {
+        return a->disabled_since_ < b->disabled_since_; });
+
+    // hibernate until back under budget
+    for (auto it = idle.begin(); it != idle.end(); ++it) {
+        if ( (ram_budget == 0 || ram <= ram_budget) && (vram_budget == 0 || vram <= vram_budget) )
+            break;
+        gsize r = 0, v = 0;
+        (*it)->memory_usage(r, v);
+        (*it)->hibernate();
+        ram -= MIN(r, ram);
+        vram -= MIN(v, vram);
+    }
+}
+
+bool MediaPlayer::isImage() const
+{
+    return media_.isimage;
+}
+
+bool MediaPlayer::isInterlaced() const
+{
+    return media_.interlaced;
+}
+
+void MediaPlayer::setDeinterlace(VideoShader::Deinterlace mode)
+{
+    if (deinterlace_ == mode)
+        return;
+    deinterlace_ = mode;
+
+    // change the conversion of the current frame (if uploaded)
+    if ( media_.interlaced && n_planes_ > 0 && !use_gl_memory_ ) {
+        init_conversion(&v_texture_info_);
+        if (yuv_buffer_)
+            convert_texture();
+    }
+}
+
+VideoShader::Deinterlace MediaPlayer::deinterlace() const
+{
+    return deinterlace_;
+}
+
+void MediaPlayer::play(bool on)
+{
+    // ignore if disabled, and cannot play an image
+    if (!enabled_ || media_.isimage)
+        return;
+
+    // request state 
+    GstState requested_state = on ? GST_STATE_PLAYING : GST_STATE_PAUSED;
+
+    // ignore if requesting twice same state
+    if (desired_state_ == requested_state)
+        return;
+
+    // accept request to the desired state
+    desired_state_ = requested_state;
+
+    // if not ready yet, the requested state will be handled later
+    if ( pipeline_ == nullptr )
+        return;
+
+    // requesting to play after scrubbing in cached frames: execute the postponed seek
+    if ( desired_state_ == GST_STATE_PLAYING && scrub_pending_)
+        execute_seek_command();
+
+    // requesting to play, but stopped at end of stream : rewind first !
+    if ( desired_state_ == GST_STATE_PLAYING) {
+        if ( ( rate_>0.0 ? media_.timeline.end() - position() : position() ) < 2 * media_.timeline.step() )
+            rewind();
+    }
+
+    // playing from the clip cache: the pipeline stays paused
+    if (clip_resident_) {
+        clip_time_ = gst_util_get_timestamp ();
+        return;
+    }
+
+    // all ready, apply state change immediately
     GstStateChangeReturn ret = gst_element_set_state (pipeline_, desired_state_);
     if (ret == GST_STATE_CHANGE_FAILURE) {
         Log::Warning("MediaPlayer %s Failed to play", gst_element_get_name(pipeline_));
@@ -484,13 +1462,11 @@ bool MediaPlayer::isPlaying(bool testpipeline) const
         return false;
 
     // if not ready yet, answer with requested state
-    if ( !testpipeline || pipeline_ == nullptr || !enabled_)
+    if ( !testpipeline || pipeline_ == nullptr || !enabled_ || clip_resident_)
         return desired_state_ == GST_STATE_PLAYING;
 
-    // if ready, answer with actual state
-    GstState state;
-    gst_element_get_state (pipeline_, &state, NULL, GST_CLOCK_TIME_NONE);
-    return state == GST_STATE_PLAYING;
+    // if ready, answer with actual state (as given by bus messages)
+    return pipeline_state_ == GST_STATE_PLAYING;
 }
 
 
@@ -524,11 +1500,49 @@ void MediaPlayer::step()
     if (!enabled_ || isPlaying())
         return;
 
+    // previous frame, exactly if the media is indexed
+    GstClockTime frame_step = media_.timeline.step();
+
+    // step in the clip cache
+    if (clip_resident_) {
+        GstClockTime begin = media_.timeline.start() != GST_CLOCK_TIME_NONE ? media_.timeline.start() : 0;
+        if (rate_ > 0.0)
+            clip_position_ = MIN(clip_position_ + frame_step, media_.timeline.end() - frame_step);
+        else
+            clip_position_ = clip_position_ > begin + frame_step ? clip_position_ - frame_step : begin;
+        return;
+    }
+
+    GstClockTime previous = GST_CLOCK_TIME_NONE;
+    if ( position_ != GST_CLOCK_TIME_NONE ) {
+        if ( media_.timeline.isIndexed() )
+            previous = media_.timeline.previousFrame(position_);
+        else if ( position_ > frame_step )
+            previous = position_ - frame_step;
+    }
+
+    // step backward in cached frames (no need to decode the GOP again)
+    if ( rate_ < 0.0 && previous != GST_CLOCK_TIME_NONE
+         && display_cached_frame(frame_cache_, previous, frame_step / 2) ) {
+        scrub_pending_ = true;
+        return;
+    }
+
+    // step backward with an accurate seek to the previous frame of the index
+    if ( rate_ < 0.0 && previous != GST_CLOCK_TIME_NONE && media_.timeline.isIndexed() ) {
+        execute_seek_command(previous);
+        return;
+    }
+
+    // execute the seek postponed while scrubbing in cached frames
+    if (scrub_pending_)
+        execute_seek_command();
+
     if ( ( rate_ < 0.0 && position_ <= media_.timeline.start() ) || ( rate_ > 0.0 && position_ >= media_.timeline.end() ) )
         rewind();
 
     // step 
-    gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_BUFFERS, 1, ABS(rate_), TRUE,  FALSE));
+    gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_BUFFERS, 1, ABS(rate_.load()), TRUE,  FALSE));
 }
 
 void MediaPlayer::seek(GstClockTime pos)
@@ -539,6 +1553,13 @@ void MediaPlayer::seek(GstClockTime pos)
     // apply seek
     GstClockTime target = CLAMP(pos, 0, media_.timeline.end());
 //    GstClockTime target = CLAMP(pos, timeline.start(), timeline.end());
+
+    // scrubbing when paused: display the cached frame and postpone the seek
+    if ( !isPlaying() && display_cached_frame(frame_cache_, target, media_.timeline.step()) ) {
+        scrub_pending_ = true;
+        return;
+    }
+
     execute_seek_command(target);
 
 }
@@ -548,109 +1569,903 @@ void MediaPlayer::jump()
     if (!enabled_ || !isPlaying())
         return;
 
-    gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_BUFFERS, 1, 30.f * ABS(rate_), TRUE,  FALSE));
+    // jump in the clip cache (about 30 frames ahead)
+    if (clip_resident_) {
+        GstClockTime begin = media_.timeline.start() != GST_CLOCK_TIME_NONE ? media_.timeline.start() : 0;
+        GstClockTime delta = static_cast<GstClockTime>( 30.0 * ABS(rate_.load()) ) * media_.timeline.step();
+        if (rate_ > 0.0)
+            clip_position_ = MIN(clip_position_ + delta, media_.timeline.end() - media_.timeline.step());
+        else
+            clip_position_ = clip_position_ > begin + delta ? clip_position_ - delta : begin;
+        return;
+    }
+
+    gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_BUFFERS, 1, 30.f * ABS(rate_.load()), TRUE,  FALSE));
+}
+
+// OpenGL layout of the planes of a video frame
+struct PlaneLayout {
+    GLint internalformat;
+    GLenum format;
+    GLsizei width;
+    GLsizei height;
+    GLint pixelstride;
+};
+
+static VideoShader::Format video_format(const GstVideoInfo *info)
+{
+    switch ( GST_VIDEO_INFO_FORMAT(info) ) {
+    case GST_VIDEO_FORMAT_I420:
+        return VideoShader::FORMAT_I420;
+    case GST_VIDEO_FORMAT_NV12:
+        return VideoShader::FORMAT_NV12;
+    case GST_VIDEO_FORMAT_YUY2:
+        return VideoShader::FORMAT_YUY2;
+    default:
+        return VideoShader::FORMAT_RGBA;
+    }
+}
+
+// fill in the layout of each plane and return the number of planes (0 if not supported)
+static guint plane_layout(const GstVideoInfo *info, PlaneLayout *layout)
+{
+    GLsizei w = GST_VIDEO_INFO_WIDTH(info);
+    GLsizei h = GST_VIDEO_INFO_HEIGHT(info);
+
+    switch ( GST_VIDEO_INFO_FORMAT(info) ) {
+    case GST_VIDEO_FORMAT_RGBA:
+        layout[0] = { GL_RGBA8, GL_RGBA, w, h, 4 };
+        return 1;
+    case GST_VIDEO_FORMAT_I420:
+        layout[0] = { GL_R8, GL_RED, w, h, 1 };
+        layout[1] = { GL_R8, GL_RED, GST_VIDEO_INFO_COMP_WIDTH(info, 1), GST_VIDEO_INFO_COMP_HEIGHT(info, 1), 1 };
+        layout[2] = { GL_R8, GL_RED, GST_VIDEO_INFO_COMP_WIDTH(info, 2), GST_VIDEO_INFO_COMP_HEIGHT(info, 2), 1 };
+        return 3;
+    case GST_VIDEO_FORMAT_NV12:
+        layout[0] = { GL_R8, GL_RED, w, h, 1 };
+        layout[1] = { GL_RG8, GL_RG, GST_VIDEO_INFO_COMP_WIDTH(info, 1), GST_VIDEO_INFO_COMP_HEIGHT(info, 1), 2 };
+        return 2;
+    case GST_VIDEO_FORMAT_YUY2:
+        // one RGBA texel per Y0 U Y1 V macro-pixel
+        layout[0] = { GL_RGBA8, GL_RGBA, (w + 1) / 2, h, 4 };
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// true if frames of both video info can be uploaded in the same textures
+static bool same_layout(const GstVideoInfo *a, const GstVideoInfo *b)
+{
+    if ( GST_VIDEO_INFO_FORMAT(a) != GST_VIDEO_INFO_FORMAT(b)
+         || GST_VIDEO_INFO_WIDTH(a) != GST_VIDEO_INFO_WIDTH(b)
+         || GST_VIDEO_INFO_HEIGHT(a) != GST_VIDEO_INFO_HEIGHT(b) )
+        return false;
+
+    for (guint p = 0; p < GST_VIDEO_INFO_N_PLANES(a); ++p) {
+        if ( GST_VIDEO_INFO_PLANE_STRIDE(a, p) != GST_VIDEO_INFO_PLANE_STRIDE(b, p) )
+            return false;
+    }
+
+    return true;
+}
+
+void MediaPlayer::memory_usage(gsize &ram, gsize &vram) const
+{
+    ram = vram = 0;
+    if (!ready_)
+        return;
+
+    // size of a decoded frame, in its format (e.g. 1.5 bytes per pixel for I420 or NV12)
+    // (until the first frame, estimated as RGBA at the current level of detail)
+    gsize frame = static_cast<gsize>(media_.width >> lod_) * static_cast<gsize>(media_.height >> lod_) * 4;
+    gsize textures = frame;
+    if (n_planes_ > 0) {
+        frame = GST_VIDEO_INFO_SIZE(&v_texture_info_);
+
+        // textures of the planes, and plane 0 of the previous frame for motion adaptive deinterlacing
+        PlaneLayout layout[N_VPLANES];
+        guint n = plane_layout(&v_texture_info_, layout);
+        textures = 0;
+        for (guint p = 0; p < n; ++p)
+            textures += static_cast<gsize>(layout[p].width) * static_cast<gsize>(layout[p].height) * layout[p].pixelstride;
+        if (previous_plane_ && n > 0)
+            textures += static_cast<gsize>(layout[0].width) * static_cast<gsize>(layout[0].height) * layout[0].pixelstride;
+    }
+
+    // frames queued from the pipeline (in OpenGL memory if zero-copy)
+    if (use_gl_memory_)
+        vram += frame * frame_.size();
+    else
+        ram += frame * frame_.size();
+
+    // (caches of decoded frames have budgets of their own)
+
+    // textures of planes and of color conversion
+    vram += textures;
+    if (yuv_buffer_)
+        vram += static_cast<gsize>(yuv_buffer_->width()) * static_cast<gsize>(yuv_buffer_->height()) * 4;
+
+    // pixel buffer objects
+    vram += static_cast<gsize>(pbo_size_) * (pbo_map_ ? N_PBO_RING : 2);
+}
+
+
+// copy the planes of a video frame into a mapped PBO, at the offsets given by info
+static void copy_planes(GLubyte *ptr, GstVideoFrame *frame, const GstVideoInfo *info)
+{
+    PlaneLayout layout[N_VPLANES];
+    guint n = plane_layout(info, layout);
+    for (guint p = 0; p < n; ++p)
+        memmove(ptr + GST_VIDEO_INFO_PLANE_OFFSET(info, p), GST_VIDEO_FRAME_PLANE_DATA(frame, p),
+                GST_VIDEO_INFO_PLANE_STRIDE(info, p) * layout[p].height);
 }
 
-void MediaPlayer::init_texture(guint index)
+void MediaPlayer::init_texture(GstVideoFrame *frame)
 {
+    const GstVideoInfo *info = &frame->info;
+
+    // free previous textures (change of format or size)
+    if (n_planes_ > 0)
+        glDeleteTextures(n_planes_, planes_);
+    textureindex_ = 0;
+
+    // create one texture per plane
+    PlaneLayout layout[N_VPLANES];
+    n_planes_ = plane_layout(info, layout);
     glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &textureindex_);
-    glBindTexture(GL_TEXTURE_2D, textureindex_);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, media_.width, media_.height);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, media_.width, media_.height,
-                    GL_RGBA, GL_UNSIGNED_BYTE, frame_[index].vframe.data[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenTextures(n_planes_, planes_);
+    for (guint p = 0; p < n_planes_; ++p) {
+        glBindTexture(GL_TEXTURE_2D, planes_[p]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, layout[p].internalformat, layout[p].width, layout[p].height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    v_texture_info_ = *info;
 
-    if (!media_.isimage) {
+    // order of fields, unless given by frames
+    field_tff_ = GST_VIDEO_INFO_FIELD_ORDER(info) != GST_VIDEO_FIELD_ORDER_BOTTOM_FIELD_FIRST;
+
+    // conversion of planes into the RGBA texture
+    init_conversion(info);
 
-        // set pbo image size
-        pbo_size_ = media_.height * media_.width * 4;
+    // initial upload
+    upload_planes(frame, false);
+
+    if (!media_.isimage) {
 
         // create pixel buffer objects,
-        if (pbo_[0])
-            glDeleteBuffers(2, pbo_);
-        glGenBuffers(2, pbo_);
-
-        for(int i = 0; i < 2; i++ ) {
-            // create 2 PBOs
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[i]);
-            // glBufferDataARB with NULL pointer reserves only memory space.
-            glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
-            // fill in with reset picture
-            GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-            if (ptr)  {
-                // update data directly on the mapped buffer
-                memmove(ptr, frame_[index].vframe.data[0], pbo_size_);
-                // release pointer to mapping buffer
-                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-            }
-            else {
-                // did not work, disable PBO
-                glDeleteBuffers(4, pbo_);
-                pbo_[0] = pbo_[1] = 0;
-                pbo_size_ = 0;
-                break;
+        free_pbo();
+
+        // set pbo image size (end of the last plane)
+        guint last = n_planes_ - 1;
+        pbo_size_ = GST_VIDEO_INFO_PLANE_OFFSET(info, last) + GST_VIDEO_INFO_PLANE_STRIDE(info, last) * layout[last].height;
+
+        // use a persistent mapped ring if possible, dual PBO otherwise
+        if ( !init_pbo_ring() ) {
+
+            glGenBuffers(2, pbo_);
+
+            for(int i = 0; i < 2; i++ ) {
+                // create 2 PBOs
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[i]);
+                // glBufferDataARB with NULL pointer reserves only memory space.
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
+                // fill in with reset picture
+                GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+                if (ptr)  {
+                    // update data directly on the mapped buffer
+                    copy_planes(ptr, frame, &v_texture_info_);
+                    // release pointer to mapping buffer
+                    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                }
+                else {
+                    // did not work, disable PBO
+                    glDeleteBuffers(2, pbo_);
+                    pbo_[0] = pbo_[1] = 0;
+                    pbo_size_ = 0;
+                    break;
+                }
+
             }
 
+            // should be good to go, wrap it up
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            pbo_index_ = 0;
+            pbo_next_index_ = 1;
+
+#ifdef MEDIA_PLAYER_DEBUG
+            Log::Info("MediaPlayer %s Using Pixel Buffer Object texturing.", id_.c_str());
+#endif
         }
+    }
 
-        // should be good to go, wrap it up
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-        pbo_index_ = 0;
-        pbo_next_index_ = 1;
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("MediaPlayer %s Uploading %s frames in %d plane(s).", id_.c_str(),
+              GST_VIDEO_INFO_NAME(info), n_planes_);
+#endif
+}
+
+bool MediaPlayer::init_pbo_ring()
+{
+    // persistent mapping requires ARB_buffer_storage (core in OpenGL 4.4)
+    if ( !GLAD_GL_ARB_buffer_storage || pbo_size_ < 1)
+        return false;
+
+    // align slots on 256 bytes
+    pbo_size_ = ((pbo_size_ + 255) / 256) * 256;
+
+    // create a single buffer for all slots, mapped once for its lifetime
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, pbo_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[0]);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, N_PBO_RING * pbo_size_, 0, flags);
+    pbo_map_ = (guint8 *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, N_PBO_RING * pbo_size_, flags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!pbo_map_) {
+        // did not work, use dual PBO
+        glDeleteBuffers(1, pbo_);
+        pbo_[0] = 0;
+        return false;
+    }
+
+    pbo_index_ = 0;
 
 #ifdef MEDIA_PLAYER_DEBUG
-        Log::Info("MediaPlayer %s Using Pixel Buffer Object texturing.", id_.c_str());
+    Log::Info("MediaPlayer %s Using persistent mapped Pixel Buffer Object ring.", id_.c_str());
 #endif
+    return true;
+}
+
+void MediaPlayer::free_pbo()
+{
+    // wait for GPU before releasing ring
+    for (guint i = 0; i < N_PBO_RING; ++i) {
+        if (pbo_fence_[i]) {
+            glClientWaitSync((GLsync) pbo_fence_[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync((GLsync) pbo_fence_[i]);
+            pbo_fence_[i] = nullptr;
+        }
+    }
+    if (pbo_map_) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[0]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pbo_map_ = nullptr;
+    }
+    if (pbo_[0])
+        glDeleteBuffers(2, pbo_);
+    pbo_[0] = pbo_[1] = 0;
+    pbo_size_ = 0;
+    for (guint i = 0; i < N_PBO_RING; ++i)
+        pbo_slot_[i].state = SLOT_FREE;
+}
+
+void MediaPlayer::init_conversion(const GstVideoInfo *info)
+{
+    // free previous conversion
+    if (yuv_buffer_) {
+        delete yuv_surface_;
+        delete yuv_buffer_;
+        yuv_surface_ = nullptr;
+        yuv_buffer_ = nullptr;
+        yuv_shader_ = nullptr;
+    }
+    if (previous_plane_)
+        glDeleteTextures(1, &previous_plane_);
+    previous_plane_ = 0;
+
+    VideoShader::Deinterlace mode = media_.interlaced ? deinterlace_ : VideoShader::DEINTERLACE_NONE;
+
+    // progressive RGBA frames are directly displayed from plane 0
+    if ( video_format(info) == VideoShader::FORMAT_RGBA && mode == VideoShader::DEINTERLACE_NONE ) {
+        textureindex_ = planes_[0];
+        return;
+    }
+
+    // YUV or interlaced frames are converted into a frame buffer
+    yuv_shader_ = new VideoShader;
+    yuv_shader_->format = video_format(info);
+    yuv_shader_->colormatrix = info->colorimetry.matrix == GST_VIDEO_COLOR_MATRIX_BT709 ?
+                VideoShader::MATRIX_BT709 : VideoShader::MATRIX_BT601;
+    yuv_shader_->fullrange = info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+    for (guint p = 0; p < n_planes_; ++p)
+        yuv_shader_->planes[p] = planes_[p];
+    yuv_shader_->deinterlace = mode;
+    set_field(false);
+
+    // motion adaptive needs plane 0 of the previous frame
+    // (interpolating fields until it holds one: its memory is undefined)
+    previous_valid_ = false;
+    if (mode == VideoShader::DEINTERLACE_ADAPTIVE) {
+        yuv_shader_->deinterlace = VideoShader::DEINTERLACE_LINEAR;
+        PlaneLayout layout[N_VPLANES];
+        plane_layout(info, layout);
+        glGenTextures(1, &previous_plane_);
+        glBindTexture(GL_TEXTURE_2D, previous_plane_);
+        glTexStorage2D(GL_TEXTURE_2D, 1, layout[0].internalformat, layout[0].width, layout[0].height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        yuv_shader_->previous = previous_plane_;
+    }
+
+    yuv_surface_ = new Surface(yuv_shader_);
+    yuv_surface_->setTextureIndex(planes_[0]);
+    yuv_buffer_ = new FrameBuffer(GST_VIDEO_INFO_WIDTH(info), GST_VIDEO_INFO_HEIGHT(info), true);
+}
+
+void MediaPlayer::set_field(bool second)
+{
+    field_second_ = second;
+    field_time_ = gst_util_get_timestamp ();
+
+    // rows of the top field are even (first rows of the texture)
+    int first = field_tff_ ? 0 : 1;
+    if (yuv_shader_)
+        yuv_shader_->field = field_second_ ? 1 - first : first;
+}
+
+void MediaPlayer::upload_planes(GstVideoFrame *frame, bool from_pbo, gsize pbo_offset)
+{
+    const GstVideoInfo *info = &v_texture_info_;
+    PlaneLayout layout[N_VPLANES];
+    plane_layout(info, layout);
+
+    // motion adaptive deinterlacing: the current plane 0 becomes the previous
+    // one, and the new frame is uploaded in the texture of the previous one
+    // (motion adaptive only once the previous one is the frame before)
+    if (previous_plane_ && yuv_shader_) {
+        std::swap(planes_[0], previous_plane_);
+        yuv_shader_->planes[0] = planes_[0];
+        yuv_shader_->previous = previous_plane_;
+        yuv_shader_->deinterlace = previous_valid_ ? VideoShader::DEINTERLACE_ADAPTIVE : VideoShader::DEINTERLACE_LINEAR;
+        yuv_surface_->setTextureIndex(planes_[0]);
+        previous_valid_ = true;
+    }
+
+    // interlaced frame: display its first field
+    if (yuv_shader_ && yuv_shader_->deinterlace != VideoShader::DEINTERLACE_NONE) {
+        if ( frame && GST_VIDEO_FRAME_IS_INTERLACED(frame) )
+            field_tff_ = GST_VIDEO_FRAME_IS_TFF(frame);
+        set_field(false);
+    }
+
+    // strides of gstreamer planes are given in bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (guint p = 0; p < n_planes_; ++p) {
+        glBindTexture(GL_TEXTURE_2D, planes_[p]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, GST_VIDEO_INFO_PLANE_STRIDE(info, p) / layout[p].pixelstride);
+        // from PBO, the data pointer is the offset of the plane in the buffer
+        const void *data = from_pbo ? (const void *) (pbo_offset + GST_VIDEO_INFO_PLANE_OFFSET(info, p))
+                                    : GST_VIDEO_FRAME_PLANE_DATA(frame, p);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, layout[p].width, layout[p].height,
+                        layout[p].format, GL_UNSIGNED_BYTE, data);
     }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // convert YUV planes to RGBA
+    if (yuv_buffer_)
+        convert_texture();
 }
 
+void MediaPlayer::convert_texture()
+{
+    static glm::mat4 identity(1.f);
+
+    yuv_buffer_->begin();
+    yuv_surface_->draw(identity, identity);
+    yuv_buffer_->end();
 
-void MediaPlayer::fill_texture(guint index)
+    textureindex_ = yuv_buffer_->texture();
+}
+
+void MediaPlayer::fill_texture(GstVideoFrame *frame)
 {
-    // is this the first frame ?
-    if (textureindex_ < 1)
+    // zero-copy: the frame is an OpenGL texture (in the shared context)
+    if (use_gl_memory_) {
+        // keep a reference to the buffer while its texture is displayed
+        gst_buffer_replace (&gl_buffer_, frame->buffer);
+        textureindex_ = *(guint *) frame->data[0];
+        return;
+    }
+
+    // is this the first frame, or did the frame layout change ?
+    if ( textureindex_ < 1 || !same_layout(&frame->info, &v_texture_info_) )
     {
         // initialize texture
-        init_texture(index);
+        init_texture(frame);
 
     }
     else {
-        glBindTexture(GL_TEXTURE_2D, textureindex_);
+        // use persistent mapped ring of Pixel Buffer Object
+        if (pbo_map_) {
+            pbo_index_ = (pbo_index_ + 1) % N_PBO_RING;
+
+            // wait for the GPU to finish reading this slot (should be signaled long ago)
+            GLsync fence = (GLsync) pbo_fence_[pbo_index_];
+            if (fence) {
+                if ( glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED ) {
+#ifdef MEDIA_PLAYER_DEBUG
+                    Log::Info("MediaPlayer %s Waiting for Pixel Buffer Object.", id_.c_str());
+#endif
+                    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+                }
+                glDeleteSync(fence);
+                pbo_fence_[pbo_index_] = nullptr;
+            }
 
+            // copy frame into the already mapped (coherent) memory of the slot
+            gsize offset = pbo_index_ * pbo_size_;
+            copy_planes(pbo_map_ + offset, frame, &v_texture_info_);
+
+            // upload from the slot immediately and fence it
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[0]);
+            upload_planes(frame, true, offset);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            pbo_fence_[pbo_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
         // use dual Pixel Buffer Object
-        if (pbo_size_ > 0) {
+        else if (pbo_size_ > 0) {
             // In dual PBO mode, increment current index first then get the next index
             pbo_index_ = (pbo_index_ + 1) % 2;
             pbo_next_index_ = (pbo_index_ + 1) % 2;
 
-            // bind PBO to read pixels
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[pbo_index_]);
-            // copy pixels from PBO to texture object
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, media_.width, media_.height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-            // bind the next PBO to write pixels
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[pbo_next_index_]);
-            // See http://www.songho.ca/opengl/gl_pbo.html#map for more details
-            glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
-            // map the buffer object into client's memory
-            GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-            if (ptr) {
-                // update data directly on the mapped buffer
-                // NB : equivalent but faster (memmove instead of memcpy ?) than
-                // glNamedBufferSubData(pboIds[nextIndex], 0, imgsize, vp->getBuffer())
-                memmove(ptr, frame_[index].vframe.data[0], pbo_size_);
+            // bind PBO to read pixels
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[pbo_index_]);
+            // copy pixels of every plane from PBO to texture objects
+            upload_planes(frame, true);
+            // bind the next PBO to write pixels
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[pbo_next_index_]);
+            // See http://www.songho.ca/opengl/gl_pbo.html#map for more details
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, 0, GL_STREAM_DRAW);
+            // map the buffer object into client's memory
+            GLubyte* ptr = (GLubyte*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+            if (ptr) {
+                // update data directly on the mapped buffer
+                // NB : equivalent but faster (memmove instead of memcpy ?) than
+                // glNamedBufferSubData(pboIds[nextIndex], 0, imgsize, vp->getBuffer())
+                copy_planes(ptr, frame, &v_texture_info_);
+
+                // release pointer to mapping buffer
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            // done with PBO
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        else {
+            // without PBO, use standard opengl (slower)
+            upload_planes(frame, false);
+        }
+    }
+}
+
+bool MediaPlayer::pop_frame(Frame &frame, const GstVideoInfo *layout)
+{
+    std::lock_guard<std::mutex> lock(queue_lock_);
+    guint size = frame_.size();
+
+    // measure average occupancy of the queue
+    guint occupancy = (write_index_ + size - read_index_) % size;
+    queue_occupancy_ = 0.9f * queue_occupancy_ + 0.1f * static_cast<float>(occupancy);
+
+    // find the most recent valid frame
+    guint index = size;
+    for (guint i = read_index_; i != write_index_; i = (i + 1) % size) {
+        if ( frame_[i].full && frame_[i].status != INVALID )
+            index = i;
+    }
+
+    // frame of another layout: leave the queue untouched (only its status is given)
+    if ( index < size && layout != nullptr && !same_layout(&frame_[index].vframe.info, layout) ) {
+        frame.status = frame_[index].status;
+        return false;
+    }
+
+    // the most recent frame is moved out (unmapped by the caller)
+    if ( index < size ) {
+        frame = frame_[index];
+        frame_[index].full = false;
+    }
+
+    // older frames are released
+    for (guint i = read_index_; i != write_index_; i = (i + 1) % size) {
+        if ( frame_[i].full ) {
+            gst_video_frame_unmap(&frame_[i].vframe);
+            frame_[i].full = false;
+        }
+        frame_[i].status = INVALID;
+    }
+    read_index_ = write_index_;
+
+    return index < size;
+}
+
+void MediaPlayer::release_frames()
+{
+    std::lock_guard<std::mutex> lock(queue_lock_);
+    guint size = frame_.size();
+
+    for (guint i = read_index_; i != write_index_; i = (i + 1) % size) {
+        if ( frame_[i].full ) {
+            gst_video_frame_unmap(&frame_[i].vframe);
+            frame_[i].full = false;
+        }
+        frame_[i].status = INVALID;
+    }
+    read_index_ = write_index_;
+}
+
+void MediaPlayer::publish_slots()
+{
+    // find the most recent slot filled by the upload thread
+    guint latest = N_PBO_RING;
+    for (guint i = 0; i < N_PBO_RING; ++i) {
+        if ( pbo_slot_[i].state.load(std::memory_order_acquire) == SLOT_FILLED ) {
+            if ( latest == N_PBO_RING || pbo_slot_[i].sequence > pbo_slot_[latest].sequence ) {
+                // older slot will not be displayed
+                if (latest < N_PBO_RING)
+                    pbo_slot_[latest].state.store(SLOT_FREE, std::memory_order_release);
+                latest = i;
+            }
+            else
+                pbo_slot_[i].state.store(SLOT_FREE, std::memory_order_release);
+        }
+        // free the slots the GPU finished reading
+        else if ( pbo_slot_[i].state.load(std::memory_order_acquire) == SLOT_UPLOADING ) {
+            GLenum ret = GL_ALREADY_SIGNALED;
+            if (pbo_fence_[i])
+                ret = glClientWaitSync((GLsync) pbo_fence_[i], 0, 0);
+            if (ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED) {
+                if (pbo_fence_[i])
+                    glDeleteSync((GLsync) pbo_fence_[i]);
+                pbo_fence_[i] = nullptr;
+                pbo_slot_[i].state.store(SLOT_FREE, std::memory_order_release);
+            }
+        }
+    }
+
+    // asynchronous transfer from the slot to the textures
+    if (latest < N_PBO_RING) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[0]);
+        upload_planes(NULL, true, latest * pbo_size_);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pbo_fence_[latest] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pbo_slot_[latest].state.store(SLOT_UPLOADING, std::memory_order_release);
+
+        // we just displayed a frame : set position time to frame PTS
+        position_ = pbo_slot_[latest].position;
+    }
+}
+
+void MediaPlayer::upload_frame()
+{
+    // only if the queue was handed over to the upload thread
+    if ( !ready_ || !worker_upload_.load(std::memory_order_acquire) )
+        return;
+
+    // find a free slot (keep frames in queue if none)
+    guint slot = N_PBO_RING;
+    for (guint i = 0; i < N_PBO_RING && slot == N_PBO_RING; ++i) {
+        if ( pbo_slot_[i].state.load(std::memory_order_acquire) == SLOT_FREE )
+            slot = i;
+    }
+    if (slot == N_PBO_RING)
+        return;
+
+    // take the most recent frame (older ones are released)
+    Frame frame;
+    if ( !pop_frame(frame, &v_texture_info_) ) {
+        // frame cannot be copied in the ring: hand the queue back to update
+        if (frame.status != INVALID)
+            worker_upload_.store(false, std::memory_order_release);
+        return;
+    }
+
+    // copy the frame into the mapped memory of the slot
+    copy_planes(pbo_map_ + slot * pbo_size_, &frame.vframe, &v_texture_info_);
+    gst_video_frame_unmap(&frame.vframe);
+    pbo_slot_[slot].position = frame.position;
+    pbo_slot_[slot].sequence = ++pbo_sequence_;
+    pbo_slot_[slot].state.store(SLOT_FILLED, std::memory_order_release);
+}
+
+void MediaPlayer::upload_worker()
+{
+    std::vector<MediaPlayer *> players;
+
+    while ( !upload_stop_.load() ) {
+        // wait for new frames (or timeout to retry frames waiting for a free slot)
+        {
+            std::unique_lock<std::mutex> lock(upload_wait_);
+            upload_condition_.wait_for(lock, std::chrono::milliseconds(5));
+        }
+
+        // media players which handed over their queue (referenced until done)
+        registry_lock_.lock();
+        for (auto it = registered_.begin(); it != registered_.end(); ++it) {
+            if ( (*it)->worker_upload_.load(std::memory_order_acquire) ) {
+                (*it)->upload_refs_++;
+                players.push_back(*it);
+            }
+        }
+        registry_lock_.unlock();
+
+        // copy frames of each media player, holding only its own lock
+        for (auto it = players.begin(); it != players.end(); ++it) {
+            (*it)->upload_lock_.lock();
+            (*it)->upload_frame();
+            (*it)->upload_lock_.unlock();
+            (*it)->upload_refs_--;
+        }
+        players.clear();
+    }
+}
+
+void MediaPlayer::terminate()
+{
+    if ( upload_thread_.joinable() ) {
+        upload_stop_ = true;
+        upload_condition_.notify_all();
+        upload_thread_.join();
+    }
+}
+
+bool MediaPlayer::cache_frames() const
+{
+    // copy frames only if they might be displayed again:
+    // when playing backward, or when scrubbing while paused
+    return frame_cache_.budget > 0 && ( rate_ < 0.0 || desired_state_ != GST_STATE_PLAYING );
+}
+
+bool MediaPlayer::cache_reverse_wanted() const
+{
+    return frame_cache_.budget > 0 && rate_ < 0.0 && desired_state_ == GST_STATE_PLAYING
+            && enabled_ && media_.seekable && !media_.isimage && !clip_resident_;
+}
+
+void MediaPlayer::take_queue()
+{
+    // the upload thread does not copy frames of this media player while the lock is held
+    // (only update hands the queue over: nothing to lock if not handed over)
+    if ( worker_upload_.load(std::memory_order_acquire) ) {
+        std::lock_guard<std::mutex> lock(upload_lock_);
+        worker_upload_ = false;
+    }
+}
+
+void MediaPlayer::set_sync(bool on)
+{
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline_), "sink");
+    if (sink) {
+        gst_base_sink_set_sync (GST_BASE_SINK(sink), on);
+        gst_object_unref (sink);
+    }
+}
+
+bool MediaPlayer::display_cached_frame(FrameCache &cache, GstClockTime target, GstClockTime tolerance)
+{
+    // need textures of a frame already displayed
+    if ( textureindex_ < 1 || use_gl_memory_ )
+        return false;
+
+    GstVideoInfo info;
+    GstBuffer *buf = cache.get(target, tolerance, &info);
+    if (buf == NULL)
+        return false;
+
+    // upload only if not already displayed
+    if (buf->pts != position_) {
+        GstVideoFrame vframe;
+        if ( gst_video_frame_map (&vframe, &info, buf, GST_MAP_READ) ) {
+            // the textures are filled here, not by the upload thread
+            take_queue();
+            fill_texture(&vframe);
+            // double update with dual PBO when scrubbing (ensure frame is displayed now)
+            if (!cache_reverse_ && !clip_resident_ && pbo_size_ > 0 && !pbo_map_)
+                fill_texture(&vframe);
+            gst_video_frame_unmap(&vframe);
+        }
+        position_ = buf->pts;
+    }
+
+    gst_buffer_unref (buf);
+    return true;
+}
+
+void MediaPlayer::update_reverse()
+{
+    // frames still in the queue are not displayed (decoded frames are in the cache)
+    release_frames();
+
+    GstClockTime step = media_.timeline.step();
+    GstClockTime begin = media_.timeline.start() != GST_CLOCK_TIME_NONE ? media_.timeline.start() : 0;
+
+    // move the play head backward as time goes
+    GstClockTime now = gst_util_get_timestamp ();
+    GstClockTime elapsed = static_cast<GstClockTime>( static_cast<double>(now - cache_time_) * ABS(rate_.load()) );
+    cache_time_ = now;
+    GstClockTime target = cache_position_ > begin + elapsed ? cache_position_ - elapsed : begin;
+
+    // display the frame at the play head (wait for decoding if not cached yet)
+    if ( display_cached_frame(frame_cache_, target, 2 * step) )
+        cache_position_ = target;
+
+    // reached the beginning: loop
+    if ( cache_position_ <= begin + step ) {
+        execute_loop_command();
+        return;
+    }
+
+    // decode the GOP before the frames cached contiguously before the play head
+    GstClockTime lookahead = static_cast<GstClockTime>( static_cast<double>(GST_SECOND / 2) * MAX(1.0, ABS(rate_.load())) );
+    GstClockTime stop = frame_cache_.earliest(cache_position_, 2 * step);
+    if ( !cache_filling_ && stop > begin && stop + lookahead > cache_position_ ) {
+        // span of decoding limited to half the share of the budget of the cache
+        GstClockTime span = static_cast<GstClockTime>( static_cast<double>(GST_SECOND) * MAX(1.0, ABS(rate_.load())) );
+        gsize framesize = GST_VIDEO_INFO_SIZE(&v_frame_video_info_);
+        if (framesize > 0)
+            span = MIN(span, static_cast<GstClockTime>(frame_cache_.share() / 2 / framesize) * step);
+        span = MAX(span, step);
+        // include the frame at the play head if not cached yet
+        if (stop == cache_position_)
+            stop += step;
+        execute_fill_command(stop > begin + span ? stop - span : begin, stop);
+    }
+}
+
+bool MediaPlayer::clip_cache_wanted() const
+{
+    // only short media, decoded in system memory
+    return clip_enabled_ && clip_budget_ > 0 && media_.seekable && !media_.isimage && !use_gl_memory_
+            && media_.timeline.duration() != GST_CLOCK_TIME_NONE
+            && media_.timeline.duration() < CLIP_CACHE_MAX_DURATION;
+}
+
+void MediaPlayer::clip_start()
+{
+    // the textures are filled by update only
+    take_queue();
+    release_frames();
+    eos_ = false;
+
+    // leave reverse playback from the cache of the pipeline
+    if (cache_reverse_) {
+        cache_reverse_ = false;
+        cache_filling_ = false;
+        set_sync(true);
+        position_ = cache_position_;
+    }
+    scrub_pending_ = false;
+    frame_cache_.clear();
+
+    clip_filling_ = false;
+    clip_resident_ = true;
+    clip_position_ = position_ != GST_CLOCK_TIME_NONE ? position_ : media_.timeline.start();
+    clip_time_ = gst_util_get_timestamp ();
+    clip_hits_ = 0;
+    clip_misses_ = 0;
+
+    // no more decoding
+    gst_element_set_state (pipeline_, GST_STATE_PAUSED);
+    rebalance_threads();
+
+#ifdef MEDIA_PLAYER_DEBUG
+    Log::Info("MediaPlayer %s Playing from clip cache (%d MB)", id_.c_str(), int(clip_cache_.size() / 1048576));
+#endif
+}
+
+void MediaPlayer::clip_stop()
+{
+    clip_filling_ = false;
+
+    // resume decoding at the play head
+    if (clip_resident_) {
+        clip_resident_ = false;
+        position_ = clip_position_;
+        if (pipeline_ != nullptr) {
+            execute_seek_command();
+            if (enabled_ || warm_)
+                gst_element_set_state (pipeline_, desired_state_);
+        }
+        timecount_.reset();
+        rebalance_threads();
+    }
+
+    clip_cache_.clear();
+}
+
+void MediaPlayer::update_clip()
+{
+    // frames decoded before the pipeline paused are not displayed
+    release_frames();
+
+    GstClockTime step = media_.timeline.step();
+    GstClockTime begin = media_.timeline.start() != GST_CLOCK_TIME_NONE ? media_.timeline.start() : 0;
+    GstClockTime end = media_.timeline.end();
+    const gint64 first = static_cast<gint64>(begin);
+    const gint64 last = static_cast<gint64>(end);
+
+    // move the play head as time goes
+    GstClockTime now = gst_util_get_timestamp ();
+    if ( desired_state_ == GST_STATE_PLAYING ) {
+        gint64 elapsed = static_cast<gint64>( static_cast<double>(now - clip_time_) * rate_ );
+        gint64 target = static_cast<gint64>(clip_position_) + elapsed;
+
+        // reached an end of the clip: loop
+        if ( target >= last || target < first ) {
+            gint64 span = MAX(last - first, 1);
+            if (loop_ == LOOP_REWIND)
+                target = rate_ > 0.0 ? first + (target - last) % span : last - (first - target) % span;
+            else if (loop_ == LOOP_BIDIRECTIONAL) {
+                rate_ = -rate_;
+                target = rate_ > 0.0 ? begin : end - step;
+            }
+            else {
+                target = rate_ > 0.0 ? end - step : begin;
+                desired_state_ = GST_STATE_PAUSED;
+            }
+        }
+        clip_position_ = static_cast<GstClockTime>(target);
+    }
+    clip_time_ = now;
+
+    // display the frame at the play head
+    GstClockTime previous = position_;
+    if ( display_cached_frame(clip_cache_, clip_position_, 2 * step) ) {
+        clip_hits_++;
+        if (position_ != previous)
+            timecount_.tic();
+    }
+    else
+        clip_misses_++;
+}
+
+void MediaPlayer::consume_frames()
+{
+    // re-opened: frames are not shown before the position to resume
+    // (those pre-rolled before seeking there are discarded, the next ones kept)
+    if (resuming_) {
+        if (resume_position_ != GST_CLOCK_TIME_NONE)
+            release_frames();
+        return;
+    }
+
+    // the upload thread consumes the queue: publish the slots it filled
+    if ( worker_upload_.load(std::memory_order_acquire) ) {
+        publish_slots();
+    }
+    // otherwise consume the queue and upload here
+    else {
+        // take the most recent frame decoded (older ones are skipped)
+        Frame frame;
+        if ( pop_frame(frame) ) {
+            // fill the texture with the frame
+            fill_texture(&frame.vframe);
+
+            // double update for pre-roll frame and dual PBO (ensure frame is displayed now)
+            if (frame.status == PREROLL && pbo_size_ > 0 && !pbo_map_)
+                fill_texture(&frame.vframe);
+
+            // we just displayed a vframe : set position time to frame PTS
+            position_ = frame.position;
 
-                // release pointer to mapping buffer
-                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-            }
-            // done with PBO
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            // done with the frame
+            gst_video_frame_unmap(&frame.vframe);
         }
-        else {
-            // without PBO, use standard opengl (slower)
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, media_.width, media_.height,
-                            GL_RGBA, GL_UNSIGNED_BYTE, frame_[index].vframe.data[0]);
+
+        // hand over the queue to the upload thread once the ring is ready
+        if (pbo_map_) {
+            // slots still read by the GPU will be freed by publish_slots
+            for (guint i = 0; i < N_PBO_RING; ++i)
+                pbo_slot_[i].state = pbo_fence_[i] ? SLOT_UPLOADING : SLOT_FREE;
+            worker_upload_.store(true, std::memory_order_release);
         }
     }
 }
@@ -661,6 +2476,10 @@ void MediaPlayer::update()
     if (failed_)
         return;
 
+    // hibernating: nothing to do until enabled
+    if (hibernated_)
+        return;
+
     // not ready yet
     if (!ready_) {
         // try to get info from discoverer
@@ -668,81 +2487,139 @@ void MediaPlayer::update()
         {
             // ok, discovering thread is finished ! Get the info
             media_ = discoverer_.get();
+            original_ = media_;
             // if its ok, open the media
-            if (media_.valid)
+            if (media_.valid) {
+                // decode the proxy transcoded before (not opening the original first)
+                if ( proxy_wanted() ) {
+                    proxy_file_ = ProxyFilename_(filename_, Settings::application.media.proxy_profile,
+                                                 Settings::application.media.proxy_height);
+                    if ( !proxy_file_.empty() && SystemToolkit::file_exists(proxy_file_) ) {
+                        ProxySize_(original_, Settings::application.media.proxy_height, proxy_width_, proxy_height_);
+                        proxy_ready_ = true;
+                        proxy_progress_ = 1.f;
+                        if (proxy_allowed_)
+                            use_proxy(true);
+                    }
+                }
                 execute_open();
+            }
         }
         // wait next frame to display
         return;
     }
 
-    // prevent unnecessary updates: disabled or already filled image
-    if (!enabled_ || (media_.isimage && textureindex_>0 ) )
+    // track state of the pipeline (never wait for it)
+    execute_bus_messages();
+    if (!ready_)
         return;
 
-    // local variables before trying to update
-    guint read_index = 0;
-    bool need_loop = false;
-
-    // locked access to changing index
-    index_lock_.lock();
-    read_index = last_index_;
-    // Do NOT miss an EOS or a pre-roll
-    for (guint i = 0; i < N_VFRAME; ++i) {
-        if ( frame_[i].status == EOS || frame_[i].status == PREROLL) {
-            read_index = i;
-            break;
-        }
+    // get the index of frames when ready (frames of the original media)
+    if ( indexer_.valid() && indexer_.wait_for( std::chrono::milliseconds(0) ) == std::future_status::ready ) {
+        original_index_ = indexer_.get();
+        if ( !original_index_.empty() && proxy_.empty() )
+            media_.timeline.setIndex(original_index_);
     }
-    index_lock_.unlock();
 
-    // lock frame while reading it
-    frame_[read_index].access.lock();
+    // the proxy is ready when transcoded
+    if ( transcoder_.valid() && transcoder_.wait_for( std::chrono::milliseconds(0) ) == std::future_status::ready )
+        proxy_ready_ = transcoder_.get();
 
-    // do not fill a frame twice
-    if (frame_[read_index].status != INVALID ) {
+    // switch to the proxy, or back to the original media when not allowed, at the same position
+    if ( proxy_ready_ && proxy_.empty() == proxy_allowed_ ) {
+        use_proxy(proxy_allowed_);
+        execute_reopen();
+        return;
+    }
 
+    // prevent unnecessary updates: already filled image
+    if (media_.isimage && textureindex_>0 )
+        return;
 
-        // is this an End-of-Stream frame ?
-        if (frame_[read_index].status == EOS )
-        {
-            // will execute seek command below (after unlock)
-            need_loop = true;
-        }
-        // otherwise just fill non-empty SAMPLE or PREROLL
-        else if (frame_[read_index].full)
-        {
-            // fill the texture with the frame at reading index
-            fill_texture(read_index);
+    // disabled: keep uploading the pre-rolled frame (e.g. after a seek or opening the proxy)
+    // so that the source is faded in from a real frame, not from black or an old frame
+    if (!enabled_ && !warm_) {
+        if (!cache_reverse_ && !clip_resident_)
+            consume_frames();
+        return;
+    }
 
-            // double update for pre-roll frame and dual PBO (ensure frame is displayed now)
-            if (frame_[read_index].status == PREROLL && pbo_size_ > 0)
-                fill_texture(read_index);
+    // the first pass did not fit in the budget of the clip cache
+    if ( clip_overflow_.exchange(false) ) {
+        clip_cache_.clear();
+        clip_enabled_ = false;
+        Log::Info("MediaPlayer %s Clip too large for cache (%d MB)", id_.c_str(), int(clip_budget_ / 1048576));
+    }
+
+    // play from the clip cache once all frames were decoded
+    if ( !clip_resident_ && clip_cache_wanted() ) {
+        if ( !clip_filling_ ) {
+            clip_cache_.clear();
+            clip_filling_ = true;
         }
+        else if ( clip_cache_.covers(media_.timeline.start() != GST_CLOCK_TIME_NONE ? media_.timeline.start() : 0,
+                                     media_.timeline.end(), 2 * media_.timeline.step()) )
+            clip_start();
+    }
+    if (clip_resident_) {
+        update_clip();
+        return;
+    }
 
-        // we just displayed a vframe : set position time to frame PTS
-        position_ = frame_[read_index].position;
+    // get End-of-Stream first: frames queued before it are visible
+    bool need_loop = eos_.exchange(false, std::memory_order_acquire);
+
+    // play backward from the cache when requested, back to the pipeline otherwise
+    if ( cache_reverse_ != cache_reverse_wanted() ) {
+        if (cache_reverse_) {
+            cache_reverse_ = false;
+            cache_filling_ = false;
+            set_sync(true);
+            // resume decoding at the play head
+            position_ = cache_position_;
+            execute_seek_command();
+        }
+        else {
+            take_queue();
+            cache_reverse_ = true;
+            cache_filling_ = false;
+            scrub_pending_ = false;
+            cache_position_ = position_ != GST_CLOCK_TIME_NONE ? position_ : media_.timeline.end();
+            cache_time_ = gst_util_get_timestamp ();
+            // decode GOPs as fast as possible
+            set_sync(false);
+            need_loop = false;
+        }
+    }
 
-        // avoid reading it again
-        frame_[read_index].status = INVALID;
+    // keep the frames around the play head in the cache
+    frame_cache_.focus(cache_reverse_ ? cache_position_ : position_, rate_);
 
-//        // TODO : try to do something when the update is too slow :(
-//        if ( timecount_.dt() > frame_duration_  * 2) {
-//            Log::Info("frame late %d", 2 * frame_duration_);
-//        }
+    // reverse playback from cache: End-of-Stream is the end of a GOP decoding
+    if (cache_reverse_) {
+        if (need_loop)
+            cache_filling_ = false;
+        update_reverse();
+        return;
     }
 
-    // unkock frame after reading it
-    frame_[read_index].access.unlock();
+    // display the most recent frame decoded
+    consume_frames();
 
-    if (seeking_) {
-        GstState state;
-        gst_element_get_state (pipeline_, &state, NULL, GST_CLOCK_TIME_NONE);
-        seeking_ = false;
+    // bob deinterlacing: display the second field at half the frame duration
+    if ( yuv_shader_ && yuv_shader_->deinterlace == VideoShader::DEINTERLACE_BOB && !field_second_
+         && desired_state_ == GST_STATE_PLAYING && media_.timeline.step() != GST_CLOCK_TIME_NONE
+         && gst_util_get_timestamp () - field_time_ > media_.timeline.step() / (2 * MAX(ABS(rate_.load()), 1.0)) ) {
+        set_field(true);
+        convert_texture();
     }
 
-    // manage loop mode
-    if (need_loop) {
+    // End-of-Stream : give a position
+    if (need_loop)
+        position_ = rate_ > 0.0 ? media_.timeline.end() : media_.timeline.start();
+
+    // manage loop mode (looping segments do not end with EOS)
+    if (need_loop && !segment_loop_) {
         execute_loop_command();
     }
 
@@ -759,13 +2636,108 @@ void MediaPlayer::update()
 }
 
 
-void MediaPlayer::execute_loop_command()
+void MediaPlayer::execute_bus_messages()
+{
+    bool reopen = false;
+    bool resumed = false;
+    bool segment_done = false;
+
+    // non-blocking read of all messages posted by the pipeline
+    GstBus *bus = gst_element_get_bus (pipeline_);
+    GstMessage *msg = NULL;
+    while ( (msg = gst_bus_pop (bus)) != NULL ) {
+
+        switch ( GST_MESSAGE_TYPE (msg) ) {
+        case GST_MESSAGE_STATE_CHANGED:
+            // keep only the state of the pipeline itself
+            if ( GST_MESSAGE_SRC (msg) == GST_OBJECT (pipeline_) ) {
+                GstState oldstate, newstate;
+                gst_message_parse_state_changed (msg, &oldstate, &newstate, NULL);
+                pipeline_state_ = newstate;
+            }
+            break;
+        case GST_MESSAGE_ASYNC_DONE:
+            // asynchronous state change or seek completed
+            seeking_ = false;
+            // re-opened and pre-rolled: seek to the position to resume
+            // (the position of the pre-rolled frame is the one to compare with)
+            if ( resume_position_ != GST_CLOCK_TIME_NONE ) {
+                GstClockTime target = resume_position_;
+                resume_position_ = GST_CLOCK_TIME_NONE;
+                position_ = GST_CLOCK_TIME_NONE;
+                execute_seek_command(target);
+                resumed = !seeking_;
+            }
+            // seek to the position to resume done
+            else if ( resuming_ )
+                resumed = true;
+            // first pre-roll done: play in looping segment
+            else if ( loop_ != LOOP_NONE && !segment_loop_ && !media_.isimage && !cache_reverse_ )
+                execute_seek_command();
+            break;
+        case GST_MESSAGE_SEGMENT_DONE:
+            // end of looping segment (instead of EOS)
+            segment_done = true;
+            break;
+        case GST_MESSAGE_ERROR:
+        {
+            GError *error = NULL;
+            gst_message_parse_error (msg, &error, NULL);
+            // zero-copy OpenGL memory could not be negotiated before the first frame:
+            // re-open using the standard system memory pipeline
+            if (use_gl_memory_ && textureindex_ < 1) {
+                Log::Info("MediaPlayer %s Cannot decode in OpenGL memory (%s); using system memory.",
+                          id_.c_str(), error ? error->message : "");
+                reopen = true;
+            }
+            else
+                Log::Warning("MediaPlayer %s Error: %s", id_.c_str(), error ? error->message : "");
+            g_clear_error (&error);
+        }
+            break;
+        default:
+            break;
+        }
+
+        gst_message_unref (msg);
+    }
+    gst_object_unref (bus);
+
+    // at the position to resume: show frames again, in the state requested meanwhile
+    if (resumed) {
+        resuming_ = false;
+        GstState requested_state = GST_STATE_PAUSED;
+        if ( (enabled_ || warm_) && !clip_resident_ )
+            requested_state = desired_state_;
+        if ( gst_element_set_state (pipeline_, requested_state) == GST_STATE_CHANGE_FAILURE ) {
+            Log::Warning("MediaPlayer %s Failed to resume", id_.c_str());
+            failed_ = true;
+        }
+    }
+
+    if (reopen) {
+        use_gl_memory_ = false;
+        close();
+        execute_open();
+    }
+    // queue the next segment while the end of the current one is still playing
+    else if (segment_done && segment_loop_ && !cache_reverse_)
+        execute_loop_command(false);
+}
+
+void MediaPlayer::execute_loop_command(bool flush)
 {
-    if (loop_==LOOP_REWIND) {
+    // at the end of a looping segment: seek without flush for gapless loop
+    if (!flush && loop_ != LOOP_NONE) {
+        if (loop_==LOOP_BIDIRECTIONAL)
+            rate_ = -rate_;
+        execute_seek_command(rate_ > 0.0 ? 0 : media_.timeline.end(), false);
+    }
+    else if (loop_==LOOP_REWIND) {
         rewind();
     } 
     else if (loop_==LOOP_BIDIRECTIONAL) {
-        rate_ *= - 1.f;
+        rate_ = -rate_;
         execute_seek_command();
     }
     else { //LOOP_NONE
@@ -773,11 +2745,27 @@ void MediaPlayer::execute_loop_command()
     }
 }
 
-void MediaPlayer::execute_seek_command(GstClockTime target)
+void MediaPlayer::execute_seek_command(GstClockTime target, bool flush)
 {
     if ( pipeline_ == nullptr || !media_.seekable)
         return;
 
+    // playback from the clip cache: only move the play head
+    if (clip_resident_) {
+        if (target != GST_CLOCK_TIME_NONE)
+            clip_position_ = target;
+        return;
+    }
+
+    // reverse playback from cache: only move the play head
+    if (cache_reverse_) {
+        if (target != GST_CLOCK_TIME_NONE) {
+            cache_position_ = target;
+            cache_filling_ = false;
+        }
+        return;
+    }
+
     // seek position : default to target
     GstClockTime seek_pos = target;
 
@@ -785,17 +2773,32 @@ void MediaPlayer::execute_seek_command(GstClockTime target)
     if (target == GST_CLOCK_TIME_NONE) 
         // create seek event with current position (rate changed ?)
         seek_pos = position();
-    // target is given but useless
-    else if ( ABS_DIFF(target, position()) < media_.timeline.step()) {
+    // target is given but useless (unless changing segment mode)
+    else if ( flush && segment_loop_ == (loop_ != LOOP_NONE)
+              && ABS_DIFF(target, position()) < media_.timeline.step()) {
         // ignore request
         return;
     }
 
-    // seek with flush (always)
-    int seek_flags = GST_SEEK_FLAG_FLUSH;
+    // seek with flush (unless queued at the end of a looping segment)
+    int seek_flags = flush ? GST_SEEK_FLAG_FLUSH : GST_SEEK_FLAG_NONE;
+    // seek in segment if looping: SEGMENT_DONE is posted instead of EOS
+    if ( loop_ != LOOP_NONE )
+        seek_flags |= GST_SEEK_FLAG_SEGMENT;
     // seek with trick mode if fast speed
-    if ( ABS(rate_) > 1.0 )
+    if ( ABS(rate_.load()) > 1.0 )
         seek_flags |= GST_SEEK_FLAG_TRICKMODE;
+    // knowing where key frames are, seek to the target frame exactly
+    // unless it is a key frame (or playing fast, where the nearest key frame is enough)
+    if ( flush && target != GST_CLOCK_TIME_NONE && media_.timeline.isIndexed() ) {
+        GstClockTime key = media_.timeline.keyframeBefore(seek_pos);
+        if ( rate_ > 0 && key != GST_CLOCK_TIME_NONE && seek_pos - key < media_.timeline.step() )
+            seek_flags |= GST_SEEK_FLAG_KEY_UNIT;
+        else if ( rate_ > 0 && ABS(rate_.load()) > 1.0 && isPlaying() )
+            seek_flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST;
+        else
+            seek_flags |= GST_SEEK_FLAG_ACCURATE;
+    }
 
     // create seek event depending on direction
     GstEvent *seek_event = nullptr;
@@ -812,14 +2815,41 @@ void MediaPlayer::execute_seek_command(GstClockTime target)
     if (seek_event && !gst_element_send_event(pipeline_, seek_event) )
         Log::Warning("MediaPlayer %s Seek failed", id_.c_str());
     else {
-        seeking_ = true;
+        // only flushing seek completes asynchronously
+        seeking_ = flush;
+        segment_loop_ = (loop_ != LOOP_NONE);
+        scrub_pending_ = false;
+        // the next frame does not follow the one displayed (deinterlacing)
+        if (flush)
+            previous_valid_ = false;
 #ifdef MEDIA_PLAYER_DEBUG
-        Log::Info("MediaPlayer %s Seek %ld %f", id_.c_str(), seek_pos, rate_);
+        Log::Info("MediaPlayer %s Seek %ld %f", id_.c_str(), seek_pos, rate_.load());
 #endif
     }
 
 }
 
+void MediaPlayer::execute_fill_command(GstClockTime start, GstClockTime stop)
+{
+    // decode forward at normal speed, from the key frame before start up to stop
+    int seek_flags = GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE;
+    GstEvent *seek_event = gst_event_new_seek (1.0, GST_FORMAT_TIME, (GstSeekFlags) seek_flags,
+        GST_SEEK_TYPE_SET, start, GST_SEEK_TYPE_SET, stop);
+
+    // Send the event (ASYNC)
+    if ( !gst_element_send_event(pipeline_, seek_event) )
+        Log::Warning("MediaPlayer %s Seek to fill cache failed", id_.c_str());
+    else {
+        // frames come in the cache until End-of-Stream at stop
+        cache_filling_ = true;
+        seeking_ = true;
+        segment_loop_ = false;
+#ifdef MEDIA_PLAYER_DEBUG
+        Log::Info("MediaPlayer %s Fill cache %ld %ld", id_.c_str(), start, stop);
+#endif
+    }
+}
+
 void MediaPlayer::setPlaySpeed(double s)
 {
     if (media_.isimage)
@@ -828,7 +2858,7 @@ void MediaPlayer::setPlaySpeed(double s)
     // bound to interval [-MAX_PLAY_SPEED MAX_PLAY_SPEED] 
     rate_ = CLAMP(s, -MAX_PLAY_SPEED, MAX_PLAY_SPEED);
     // skip interval [-MIN_PLAY_SPEED MIN_PLAY_SPEED]
-    if (ABS(rate_) < MIN_PLAY_SPEED)
+    if (ABS(rate_.load()) < MIN_PLAY_SPEED)
         rate_ = SIGN(rate_) * MIN_PLAY_SPEED;
         
     // apply with seek
@@ -870,73 +2900,332 @@ double MediaPlayer::updateFrameRate() const
     return timecount_.frameRate();
 }
 
+float MediaPlayer::queueOccupancy() const
+{
+    return queue_occupancy_;
+}
+
+guint MediaPlayer::queueSize() const
+{
+    return frame_.size() > 0 ? frame_.size() - 1 : 0;
+}
+
+guint MediaPlayer::droppedFrames() const
+{
+    return dropped_frames_;
+}
+
+gsize MediaPlayer::cacheSize() const
+{
+    return frame_cache_.size();
+}
+
+bool MediaPlayer::proxy_wanted() const
+{
+    // heavy media: high resolution or high bitrate
+    return Settings::application.media.proxy && !proxy_ready_ && !original_.isimage && original_.seekable
+            && ( ( Settings::application.media.proxy_height > 0 && original_.height > (guint) Settings::application.media.proxy_height )
+                 || original_.bitrate > PROXY_MIN_BITRATE );
+}
+
+void MediaPlayer::use_proxy(bool on)
+{
+    if (on) {
+        gchar *uritmp = gst_filename_to_uri(proxy_file_.c_str(), NULL);
+        proxy_ = string( uritmp );
+        g_free(uritmp);
+        // frames of the proxy have square pixels, are progressive,
+        // and the key frames of the original media are not those of the proxy
+        media_.width = media_.par_width = proxy_width_;
+        media_.height = proxy_height_;
+        media_.interlaced = false;
+        media_.timeline.setIndex( FrameIndex() );
+    }
+    else {
+        proxy_.clear();
+        media_.width = original_.width;
+        media_.par_width = original_.par_width;
+        media_.height = original_.height;
+        media_.interlaced = original_.interlaced;
+        media_.timeline.setIndex( original_index_ );
+    }
+}
+
+void MediaPlayer::execute_reopen()
+{
+    // resume at the position of the last frame displayed
+    GstClockTime pos = position_;
+    close();
+    resume_position_ = pos;
+    execute_open();
+}
+
+bool MediaPlayer::usesProxy() const
+{
+    return !proxy_.empty();
+}
+
+float MediaPlayer::proxyProgress() const
+{
+    return proxy_progress_;
+}
+
+void MediaPlayer::setClipCache(bool on)
+{
+    clip_enabled_ = on;
+    if (!on)
+        clip_stop();
+}
+
+bool MediaPlayer::clipCache() const
+{
+    return clip_enabled_;
+}
+
+bool MediaPlayer::clipResident() const
+{
+    return clip_resident_;
+}
+
+gsize MediaPlayer::clipCacheSize() const
+{
+    return clip_cache_.size();
+}
+
+float MediaPlayer::clipHitRate() const
+{
+    guint64 total = clip_hits_ + clip_misses_;
+    return total > 0 ? static_cast<float>(clip_hits_) / static_cast<float>(total) : 0.f;
+}
+
+
+float MediaPlayer::decodeTime() const
+{
+    return decode_time_;
+}
+
+guint MediaPlayer::decoderThreads() const
+{
+    return threads_;
+}
+
+void MediaPlayer::set_threads(guint n)
+{
+    if (threads_ == n)
+        return;
+    threads_ = n;
+
+    // NB: converters apply a new number of threads when negotiating again (e.g. level of detail),
+    // but decoders only when opening their codec: a running decoder keeps the number it had
+    std::lock_guard<std::mutex> lock(threaded_lock_);
+    for (auto it = threaded_.begin(); it != threaded_.end(); ++it) {
+        GObjectClass *klass = G_OBJECT_GET_CLASS (*it);
+        if ( g_object_class_find_property (klass, "max-threads") )
+            g_object_set (G_OBJECT (*it), "max-threads", (gint) n, NULL);
+        else if ( g_object_class_find_property (klass, "n-threads") )
+            g_object_set (G_OBJECT (*it), "n-threads", (guint) n, NULL);
+    }
+}
+
+bool MediaPlayer::decoding() const
+{
+    // enabled or warm, not an image, not playing from the clip cache
+    return (enabled_ || warm_) && !media_.isimage && !clip_resident_;
+}
+
+void MediaPlayer::rebalance_threads()
+{
+    std::lock_guard<std::mutex> lock(registry_lock_);
+
+    guint active = 0;
+    for (auto it = registered_.begin(); it != registered_.end(); ++it)
+        if ( (*it)->decoding() )
+            active++;
+
+    // equal share of the budget for media players decoding
+    // (the others are paused: they keep their share, used when decoding again)
+    guint share = DecoderThreads_(active);
+    for (auto it = registered_.begin(); it != registered_.end(); ++it)
+        if ( (*it)->decoding() )
+            (*it)->set_threads( share );
+}
 
 // CALLBACKS
 
-bool MediaPlayer::fill_frame(GstBuffer *buf, FrameStatus status)
+void MediaPlayer::callback_element_added (GstBin *, GstBin *, GstElement *element, gpointer p)
 {
-    // lock access to frame
-    frame_[write_index_].access.lock();
+    MediaPlayer *m = static_cast<MediaPlayer *>(p);
+    if (!m || !element)
+        return;
 
-    // always empty frame before filling it again
-    if ( frame_[write_index_].full ) {
-        gst_video_frame_unmap(&frame_[write_index_].vframe);
-        frame_[write_index_].full = false;
+    GObjectClass *klass = G_OBJECT_GET_CLASS (element);
+    bool max_threads = g_object_class_find_property (klass, "max-threads") != NULL;
+    bool n_threads = g_object_class_find_property (klass, "n-threads") != NULL;
+
+    // set the number of threads of decoders and converters before they are configured
+    if ( max_threads || n_threads ) {
+        guint n = m->threads_;
+        if (max_threads)
+            g_object_set (G_OBJECT (element), "max-threads", (gint) n, NULL);
+        else
+            g_object_set (G_OBJECT (element), "n-threads", n, NULL);
+        std::lock_guard<std::mutex> lock(m->threaded_lock_);
+        m->threaded_.push_back( GST_ELEMENT (gst_object_ref (element)) );
     }
 
-    // accept status of frame received
-    frame_[write_index_].status = status;
+    // measure the time spent by the video decoder on each frame
+    GstElementFactory *factory = gst_element_get_factory (element);
+    const gchar *klassname = factory ? gst_element_factory_get_metadata (factory, GST_ELEMENT_METADATA_KLASS) : NULL;
+    if ( klassname && g_strrstr (klassname, "Decoder") && g_strrstr (klassname, "Video") ) {
+        GstPad *sinkpad = gst_element_get_static_pad (element, "sink");
+        GstPad *srcpad = gst_element_get_static_pad (element, "src");
+        if (sinkpad && srcpad) {
+            gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER, callback_decoder_input, m, NULL);
+            gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER, callback_decoder_output, m, NULL);
+        }
+        if (sinkpad)
+            gst_object_unref (sinkpad);
+        if (srcpad)
+            gst_object_unref (srcpad);
+    }
+}
 
-    // a buffer is given (not EOS)
-    if (buf != NULL) {
+GstPadProbeReturn MediaPlayer::callback_decoder_input (GstPad *, GstPadProbeInfo *, gpointer p)
+{
+    MediaPlayer *m = static_cast<MediaPlayer *>(p);
+    // time when a compressed frame enters the decoder
+    m->decode_start_ = gst_util_get_timestamp ();
+    return GST_PAD_PROBE_OK;
+}
 
-        // get the frame from buffer
-        if ( !gst_video_frame_map (&frame_[write_index_].vframe, &v_frame_video_info_, buf, GST_MAP_READ ) )
-        {
-            Log::Info("MediaPlayer %s Failed to map the video buffer", id_.c_str());
-            // free access to frame & exit
-            frame_[write_index_].status = INVALID;
-            frame_[write_index_].access.unlock();
-            return false;
+GstPadProbeReturn MediaPlayer::callback_decoder_output (GstPad *, GstPadProbeInfo *, gpointer p)
+{
+    MediaPlayer *m = static_cast<MediaPlayer *>(p);
+    // first decoded frame out of the decoder since the last input
+    GstClockTime start = m->decode_start_.exchange(GST_CLOCK_TIME_NONE);
+    if ( start != GST_CLOCK_TIME_NONE ) {
+        float dt = static_cast<float>( GST_TIME_AS_USECONDS(gst_util_get_timestamp () - start) ) * 0.001f;
+        // running average
+        m->decode_time_ = m->decode_time_ < 0.001f ? dt : 0.9f * m->decode_time_ + 0.1f * dt;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+bool MediaPlayer::fill_frame(GstBuffer *buf, FrameStatus status)
+{
+    // null buffer for EOS: inform update (out of the queue to never miss it)
+    if (buf == NULL || status == EOS) {
+        eos_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // first pass of the clip cache: keep a copy of all frames
+    if ( clip_filling_.load(std::memory_order_relaxed) ) {
+        if ( clip_cache_pool_.bytes.load() + gst_buffer_get_size(buf) > clip_budget_ ) {
+            clip_filling_ = false;
+            clip_overflow_ = true;
+        }
+        else {
+            PlaneLayout layout[N_VPLANES];
+            if ( plane_layout(&v_frame_video_info_, layout) > 0 )
+                clip_cache_.add(buf, &v_frame_video_info_);
         }
+    }
 
-        // successfully filled the frame
-        frame_[write_index_].full = true;
+    // keep a copy of frames which might be displayed again
+    if ( cache_frames() ) {
+        PlaneLayout layout[N_VPLANES];
+        if ( plane_layout(&v_frame_video_info_, layout) > 0 )
+            frame_cache_.add(buf, &v_frame_video_info_);
+        // reverse playback displays frames from the cache only
+        if (cache_reverse_)
+            return true;
+    }
 
-        // validate frame format
-        if( GST_VIDEO_INFO_IS_RGB(&(frame_[write_index_].vframe).info) && GST_VIDEO_INFO_N_PLANES(&(frame_[write_index_].vframe).info) == 1)
-        {
-            // set presentation time stamp
-            frame_[write_index_].position = buf->pts;
+    // the frame is prepared before entering the queue
+    Frame frame;
+    frame.status = status;
 
-            // set the start position (i.e. pts of first frame we got)
-            if (media_.timeline.start() == GST_CLOCK_TIME_NONE) {
-                media_.timeline.setStart(buf->pts);
-                Log::Info("Timeline %ld  [%ld %ld]", media_.timeline.numFrames(), media_.timeline.start(), media_.timeline.end());
-            }
+    // get the frame from buffer (as a texture if in OpenGL memory)
+    GstMapFlags flags = use_gl_memory_ ? (GstMapFlags) (GST_MAP_READ | GST_MAP_GL) : GST_MAP_READ;
+    if ( !gst_video_frame_map (&frame.vframe, &v_frame_video_info_, buf, flags ) )
+    {
+        Log::Info("MediaPlayer %s Failed to map the video buffer", id_.c_str());
+        return false;
+    }
+
+    // validate frame format (must be one that can be uploaded)
+    // (should never happen)
+    PlaneLayout layout[N_VPLANES];
+    if( plane_layout(&frame.vframe.info, layout) < 1 ) {
+        gst_video_frame_unmap(&frame.vframe);
+        return true;
+    }
+
+    // successfully filled the frame
+    frame.full = true;
+
+    // wait for gstreamer to finish rendering the texture
+    if (use_gl_memory_) {
+        GstGLSyncMeta *sync_meta = gst_buffer_get_gl_sync_meta (buf);
+        if (sync_meta)
+            gst_gl_sync_meta_wait_cpu (sync_meta, sync_meta->context);
+    }
+
+    // set presentation time stamp
+    frame.position = buf->pts;
+
+    // set the start position (i.e. pts of first frame we got)
+    if (media_.timeline.start() == GST_CLOCK_TIME_NONE) {
+        media_.timeline.setStart(buf->pts);
+        Log::Info("Timeline %ld  [%ld %ld]", media_.timeline.numFrames(), media_.timeline.start(), media_.timeline.end());
+    }
+
+    // give the frame to update (or to the upload thread)
+    queue_lock_.lock();
+    guint size = frame_.size();
+    guint next = (write_index_ + 1) % size;
+
+    // queue is full: drop the oldest frame rather than waiting for update
+    if ( next == read_index_ ) {
+        // the oldest frame not pre-rolled (a pre-roll is displayed after a seek)
+        guint drop = size;
+        for (guint i = read_index_; i != write_index_ && drop == size; i = (i + 1) % size) {
+            if ( frame_[i].status != PREROLL )
+                drop = i;
         }
-        // full but invalid frame : will be deleted next iteration
-        // (should never happen)
-        else
-            frame_[write_index_].status = INVALID;
+        // only pre-rolled frames queued: replaced only by a newer pre-roll
+        if ( drop == size && status == PREROLL )
+            drop = read_index_;
+
+        if ( drop < size ) {
+            if ( frame_[drop].full )
+                gst_video_frame_unmap(&frame_[drop].vframe);
+            // frames queued before the dropped one move forward
+            for (guint i = drop; i != read_index_; i = (i + size - 1) % size)
+                frame_[i] = frame_[(i + size - 1) % size];
+            frame_[read_index_].full = false;
+            frame_[read_index_].status = INVALID;
+            read_index_ = (read_index_ + 1) % size;
+        }
+        dropped_frames_++;
     }
-    // else; null buffer for EOS: give a position
-    else {
-        frame_[write_index_].status = EOS;
-        frame_[write_index_].position = rate_ > 0.0 ? media_.timeline.end() : media_.timeline.start();
+
+    bool queued = ( next != read_index_ );
+    if (queued) {
+        frame_[write_index_] = frame;
+        write_index_ = next;
     }
+    queue_lock_.unlock();
 
-    // unlock access to frame
-    frame_[write_index_].access.unlock();
+    // the new frame was dropped
+    if (!queued) {
+        gst_video_frame_unmap(&frame.vframe);
+        return true;
+    }
 
-    // lock access to index change (very quick)
-    index_lock_.lock();
-    // indicate update that this is the last frame filled (and unlocked)
-    last_index_ = write_index_;
-    // for writing, we will access the next in stack
-    write_index_ = (write_index_ + 1) % N_VFRAME;
-    // unlock access to index change
-    index_lock_.unlock();
+    if ( worker_upload_.load(std::memory_order_relaxed) )
+        upload_condition_.notify_one();
 
     // calculate actual FPS of update
     timecount_.tic();
@@ -968,11 +3257,14 @@ GstFlowReturn MediaPlayer::callback_new_preroll (GstAppSink *sink, gpointer p)
         // send frames to media player only if ready
         MediaPlayer *m = (MediaPlayer *)p;
         if (m && m->ready_) {
+            // update video frame info if negotiated caps changed
+            if ( gst_caps_replace (&m->v_frame_caps_, gst_sample_get_caps (sample)) )
+                gst_video_info_from_caps (&m->v_frame_video_info_, m->v_frame_caps_);
             // fill frame from buffer
             if ( !m->fill_frame(buf, MediaPlayer::PREROLL) )
                 ret = GST_FLOW_ERROR;
             // loop negative rate: emulate an EOS
-            else if (m->playSpeed() < 0.f && buf->pts <= m->media_.timeline.start()) {
+            else if (m->playSpeed() < 0.f && !m->cache_reverse_ && buf->pts <= m->media_.timeline.start()) {
                 m->fill_frame(NULL, MediaPlayer::EOS);
             }
         }
@@ -1002,11 +3294,14 @@ GstFlowReturn MediaPlayer::callback_new_sample (GstAppSink *sink, gpointer p)
         // send frames to media player only if ready
         MediaPlayer *m = (MediaPlayer *)p;
         if (m && m->ready_) {
+            // update video frame info if negotiated caps changed
+            if ( gst_caps_replace (&m->v_frame_caps_, gst_sample_get_caps (sample)) )
+                gst_video_info_from_caps (&m->v_frame_video_info_, m->v_frame_caps_);
             // fill frame with buffer
             if ( !m->fill_frame(buf, MediaPlayer::SAMPLE) )
                 ret = GST_FLOW_ERROR;
             // loop negative rate: emulate an EOS
-            else if (m->playSpeed() < 0.f && buf->pts <= m->media_.timeline.start()) {
+            else if (m->playSpeed() < 0.f && !m->cache_reverse_ && buf->pts <= m->media_.timeline.start()) {
                 m->fill_frame(NULL, MediaPlayer::EOS);
             }
         }
@@ -1022,6 +3317,173 @@ GstFlowReturn MediaPlayer::callback_new_sample (GstAppSink *sink, gpointer p)
 
 
 
+MediaPlayer::FrameCache::FrameCache()
+{
+    bytes = 0;
+    budget = 0;
+    pool = nullptr;
+    reference = GST_CLOCK_TIME_NONE;
+    direction = 1.0;
+    gst_video_info_init (&info);
+}
+
+MediaPlayer::FrameCache::~FrameCache()
+{
+    clear();
+}
+
+void MediaPlayer::FrameCache::add(GstBuffer *buf, const GstVideoInfo *vinfo)
+{
+    if (budget < 1 || !GST_CLOCK_TIME_IS_VALID(buf->pts))
+        return;
+
+    // the decoder needs its buffers back: keep a copy
+    GstBuffer *copy = gst_buffer_copy_deep (buf);
+    if (copy == NULL)
+        return;
+
+    std::lock_guard<std::mutex> lock(access);
+
+    // frames of another format cannot be displayed anymore
+    if ( !gst_video_info_is_equal (&info, vinfo) ) {
+        for (auto it = frames.begin(); it != frames.end(); ++it)
+            gst_buffer_unref (it->second);
+        frames.clear();
+        set_bytes(0);
+        info = *vinfo;
+    }
+
+    // already cached
+    if ( frames.count(buf->pts) > 0 ) {
+        gst_buffer_unref (copy);
+        return;
+    }
+    frames[buf->pts] = copy;
+    set_bytes(bytes + gst_buffer_get_size (copy));
+
+    // a cache is reduced to its equal share of the budget of the pool,
+    // never below it for the frames of the others
+    gsize limit = equal_share();
+
+    // over budget: remove the frames farthest from the reference, i.e. the first
+    // or the last one (those behind it in the direction of play count more)
+    GstClockTime ref = reference != GST_CLOCK_TIME_NONE ? reference : buf->pts;
+    while ( bytes > limit && frames.size() > 1 ) {
+        GstClockTime first = ABS_DIFF(frames.begin()->first, ref);
+        GstClockTime last = ABS_DIFF(frames.rbegin()->first, ref);
+        if ( direction > 0.0 ? frames.begin()->first < ref : frames.begin()->first > ref )
+            first *= 4;
+        if ( direction > 0.0 ? frames.rbegin()->first < ref : frames.rbegin()->first > ref )
+            last *= 4;
+        auto farthest = first > last ? frames.begin() : std::prev(frames.end());
+        set_bytes(bytes - gst_buffer_get_size (farthest->second));
+        gst_buffer_unref (farthest->second);
+        frames.erase(farthest);
+    }
+}
+
+GstBuffer *MediaPlayer::FrameCache::get(GstClockTime target, GstClockTime tolerance, GstVideoInfo *vinfo)
+{
+    std::lock_guard<std::mutex> lock(access);
+
+    // the frame displayed at target is the last one starting before
+    auto it = frames.upper_bound(target);
+    if (it == frames.begin())
+        return NULL;
+    --it;
+    if (target - it->first > tolerance)
+        return NULL;
+
+    *vinfo = info;
+    return gst_buffer_ref (it->second);
+}
+
+GstClockTime MediaPlayer::FrameCache::earliest(GstClockTime from, GstClockTime gap)
+{
+    std::lock_guard<std::mutex> lock(access);
+
+    // walk back the frames cached without gap before from
+    GstClockTime e = from;
+    auto it = frames.upper_bound(from);
+    while (it != frames.begin()) {
+        --it;
+        if (e - it->first > gap)
+            break;
+        e = it->first;
+    }
+
+    return e;
+}
+
+void MediaPlayer::FrameCache::focus(GstClockTime position, gdouble rate)
+{
+    std::lock_guard<std::mutex> lock(access);
+    reference = position;
+    direction = rate;
+}
+
+bool MediaPlayer::FrameCache::covers(GstClockTime begin, GstClockTime end, GstClockTime gap)
+{
+    std::lock_guard<std::mutex> lock(access);
+
+    // frames from begin to end, without gap
+    if ( frames.empty() || frames.begin()->first > begin + gap || frames.rbegin()->first + gap < end )
+        return false;
+    GstClockTime previous = frames.begin()->first;
+    for (auto it = frames.begin(); it != frames.end(); ++it) {
+        if (it->first - previous > gap)
+            return false;
+        previous = it->first;
+    }
+
+    return true;
+}
+
+void MediaPlayer::FrameCache::clear()
+{
+    std::lock_guard<std::mutex> lock(access);
+    for (auto it = frames.begin(); it != frames.end(); ++it)
+        gst_buffer_unref (it->second);
+    frames.clear();
+    set_bytes(0);
+    reference = GST_CLOCK_TIME_NONE;
+}
+
+gsize MediaPlayer::FrameCache::size() const
+{
+    std::lock_guard<std::mutex> lock(access);
+    return bytes;
+}
+
+gsize MediaPlayer::FrameCache::share() const
+{
+    std::lock_guard<std::mutex> lock(access);
+    return equal_share();
+}
+
+gsize MediaPlayer::FrameCache::equal_share() const
+{
+    // equal share among the caches holding frames (this one included)
+    if (!pool)
+        return budget;
+    guint caches = pool->caches.load() + (bytes > 0 ? 0 : 1);
+    return budget / MAX(caches, 1u);
+}
+
+void MediaPlayer::FrameCache::set_bytes(gsize b)
+{
+    // keep the pool informed (called with access locked)
+    if (pool) {
+        pool->bytes += b;
+        pool->bytes -= bytes;
+        if (bytes == 0 && b > 0)
+            pool->caches++;
+        else if (bytes > 0 && b == 0)
+            pool->caches--;
+    }
+    bytes = b;
+}
+
 MediaPlayer::TimeCounter::TimeCounter() {
 
     reset();
@@ -2,9 +2,13 @@
 #define __GST_MEDIA_PLAYER_H_
 
 #include <string>
+#include <vector>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <future>
+#include <thread>
+#include <map>
 
 // GStreamer
 #include <gst/pbutils/gstdiscoverer.h>
@@ -12,13 +16,20 @@
 #include <gst/app/gstappsink.h>
 
 #include "Timeline.h"
+#include "VideoShader.h"
 
 // Forward declare classes referenced
 class Visitor;
+class FrameBuffer;
+class Surface;
 
 #define MAX_PLAY_SPEED 20.0
 #define MIN_PLAY_SPEED 0.1
-#define N_VFRAME 3
+#define MAX_VFRAME 16
+#define N_PBO_RING 3
+#define MAX_LOD 3
+#define CLIP_CACHE_MAX_DURATION (10 * GST_SECOND)
+#define PROXY_MIN_BITRATE 50000000
 
 struct MediaInfo {
 
@@ -120,10 +131,59 @@ public:
      * True if enabled
      * */
     bool isEnabled() const;
+    /**
+     * Warm / Cool a disabled media player
+     * Runs the pipeline in its desired state when it is
+     * expected to be enabled soon (frames flow when enabled)
+     * */
+    void warm(bool on);
+    /**
+     * True if warm (disabled but running)
+     * */
+    bool isWarm() const;
+    /**
+     * Hibernate a disabled media player: release its pipeline,
+     * frames and textures (restored in background when enabled or warmed)
+     * */
+    void hibernate();
+    /**
+     * True if hibernating (resources released)
+     * */
+    bool isHibernating() const;
+    /**
+     * True if re-opened and not yet back at its position
+     * (e.g. after hibernation ; no frame is shown meanwhile)
+     * */
+    bool isResuming() const;
+    /**
+     * Estimate of the memory used by all media players, in bytes
+     * (RAM for frames, VRAM for textures and buffers, RAM for caches of frames)
+     * */
+    static void memoryUsage(gsize &ram, gsize &vram, gsize &cache);
+    /**
+     * Hibernate media players disabled for long, least recently used first,
+     * while the memory used by media players exceeds the budget
+     * (called once per frame)
+     * */
+    static void manageResidency();
+    /**
+     * Stop the thread uploading the frames of media players
+     * (at exit; restarted if a media is opened again)
+     * */
+    static void terminate();
     /**
      * True if its an image
      * */
     bool isImage() const;
+    /**
+     * True if the frames are interlaced
+     * */
+    bool isInterlaced() const;
+    /**
+     * Deinterlacing of interlaced frames (on GPU)
+     * */
+    void setDeinterlace(VideoShader::Deinterlace mode);
+    VideoShader::Deinterlace deinterlace() const;
     /**
      * Pause / Play
      * Can play backward if play speed is negative
@@ -131,7 +191,8 @@ public:
     void play(bool on);
     /**
      * Get Pause / Play status
-     * Performs a full check of the Gstreamer pipeline if testpipeline is true
+     * Answers with the last state reported by the Gstreamer pipeline
+     * if testpipeline is true (never waits for a state change)
      * */
     bool isPlaying(bool testpipeline = false) const;
     /**
@@ -202,6 +263,77 @@ public:
      * measured during play
      * */
     double updateFrameRate() const;
+    /**
+     * Get average number of decoded frames
+     * waiting in queue to be displayed
+     * */
+    float queueOccupancy() const;
+    /**
+     * Get size of the queue of decoded frames
+     * */
+    guint queueSize() const;
+    /**
+     * Get number of decoded frames dropped
+     * because the queue was full
+     * */
+    guint droppedFrames() const;
+    /**
+     * Get memory used by the cache of decoded frames
+     * (in bytes)
+     * */
+    gsize cacheSize() const;
+    /**
+     * Keep all decoded frames of a short media (< 10s)
+     * after a first pass, and play from memory without decoding
+     * */
+    void setClipCache(bool on);
+    bool clipCache() const;
+    /**
+     * True if the media plays from the clip cache
+     * */
+    bool clipResident() const;
+    /**
+     * Get memory used by the clip cache
+     * (in bytes)
+     * */
+    gsize clipCacheSize() const;
+    /**
+     * Get ratio of frames found in the clip cache
+     * since it is resident
+     * */
+    float clipHitRate() const;
+    /**
+     * True if frames are decoded from a proxy of the media
+     * (transcoded in background when the media is heavy)
+     * */
+    bool usesProxy() const;
+    /**
+     * Get progress of the transcoding of the proxy [0 1]
+     * (negative if no proxy is transcoded)
+     * */
+    float proxyProgress() const;
+    /**
+     * Get folder of proxy files
+     * */
+    static std::string proxyPath();
+    /**
+     * Get number of media waiting for or under transcoding
+     * */
+    static int proxyPending();
+    /**
+     * Decode the proxies of heavy media, or their originals
+     * (proxies are not allowed while recording)
+     * */
+    static void allowProxy(bool on);
+    /**
+     * Get average time to decode a frame (in ms)
+     * */
+    float decodeTime() const;
+    /**
+     * Get number of threads given to the decoder
+     * (share of the global budget of decoding threads)
+     * */
+    guint decoderThreads() const;
     /**
      * Get frame width
      * */
@@ -210,6 +342,16 @@ public:
      * Get frame height
      * */
     guint height() const;
+    /**
+     * Set the height (in pixels) at which the frames are displayed
+     * Frames are decoded at a lower resolution if it is enough
+     * */
+    void setDisplayHeight(guint h);
+    /**
+     * Get the level of detail of decoded frames
+     * 0 for full resolution, 1 for half, 2 for quarter, etc.
+     * */
+    guint levelOfDetail() const;
     /**
      * Get frames displayt aspect ratio
      * NB: can be different than width() / height()
@@ -244,18 +386,65 @@ private:
     // general properties of media
     MediaInfo media_;
     std::future<MediaInfo> discoverer_;
+    std::future<FrameIndex> indexer_;
+    std::atomic<bool> index_cancel_;
+
+    // proxy of heavy media: transcoded in background, then decoded instead
+    // of the original (filename_ and uri_ remain those of the original)
+    std::string proxy_;
+    std::future<bool> transcoder_;
+    std::string proxy_file_;
+    guint proxy_width_, proxy_height_;
+    std::atomic<bool> proxy_cancel_;
+    std::atomic<float> proxy_progress_;
+    bool proxy_ready_;
+    static bool proxy_allowed_;
+    bool proxy_wanted() const;
+    void use_proxy(bool on);
+
+    // information of the original media (restored when decoded instead of its proxy)
+    MediaInfo original_;
+    FrameIndex original_index_;
+
+    // re-open at the position of the last frame displayed (switch to or from
+    // the proxy, end of hibernation): pre-rolled in pause and seeked there,
+    // then frames are shown again and the desired state is restored
+    GstClockTime resume_position_;
+    bool resuming_;
+    void execute_reopen();
+
+    // hibernation of media players disabled for long, least recently used first,
+    // while the memory used by media players exceeds the budget
+    bool hibernated_;
+    GstClockTime disabled_since_;
+    void wake();
+    void memory_usage(gsize &ram, gsize &vram) const;
 
     // GST & Play status
+    // (rate and desired state are also read by the streaming thread)
     GstClockTime position_;
-    gdouble rate_;
+    std::atomic<gdouble> rate_;
     LoopMode loop_;
-    GstState desired_state_;
+    std::atomic<GstState> desired_state_;
+    GstState pipeline_state_;
     GstElement *pipeline_;
+    GstCaps *v_frame_caps_;
     GstVideoInfo v_frame_video_info_;
     std::atomic<bool> ready_;
     std::atomic<bool> failed_;
     bool seeking_;
+    bool segment_loop_;
     bool enabled_;
+    bool warm_;
+
+    // resolution of decoded frames (divided by 2^lod_)
+    bool scalable_;
+    guint lod_;
+    GstCaps *frame_caps() const;
+
+    // zero-copy decoding in OpenGL memory
+    bool use_gl_memory_;
+    GstBuffer *gl_buffer_;
 
     // fps counter
     struct TimeCounter {
@@ -273,6 +462,68 @@ private:
     };
     TimeCounter timecount_;
 
+    // memory of the caches of all media players
+    struct CachePool {
+        std::atomic<gsize> bytes;
+        std::atomic<guint> caches; // caches holding frames
+        CachePool() : bytes(0), caches(0) {}
+    };
+
+    // cache of decoded frames (copies) for reverse playback and scrubbing
+    // filled by the streaming thread, read by update
+    // (the budget of the pool is shared equally by the caches holding frames)
+    struct FrameCache {
+
+        std::map<GstClockTime, GstBuffer *> frames;
+        GstVideoInfo info;
+        gsize bytes;
+        gsize budget;
+        CachePool *pool;
+        GstClockTime reference;
+        gdouble direction;
+        mutable std::mutex access;
+    public:
+        FrameCache();
+        ~FrameCache();
+        void add(GstBuffer *buf, const GstVideoInfo *vinfo);
+        GstBuffer *get(GstClockTime target, GstClockTime tolerance, GstVideoInfo *vinfo);
+        GstClockTime earliest(GstClockTime from, GstClockTime gap);
+        void focus(GstClockTime position, gdouble rate);
+        bool covers(GstClockTime begin, GstClockTime end, GstClockTime gap);
+        void clear();
+        gsize size() const;
+        gsize share() const;
+    private:
+        void set_bytes(gsize b);
+        gsize equal_share() const;
+    };
+    FrameCache frame_cache_;
+    static CachePool frame_cache_pool_;
+
+    // reverse playback from cache: the pipeline decodes forward (one GOP at a time)
+    // and update moves a virtual play head backward in the cache
+    std::atomic<bool> cache_reverse_;
+    bool cache_filling_;
+    GstClockTime cache_position_;
+    GstClockTime cache_time_;
+    // seek postponed while scrubbing in cached frames
+    bool scrub_pending_;
+
+    // clip cache: all frames of a short media are kept during a first pass,
+    // then update displays them while the pipeline is paused
+    // (the budget limits the first pass, for the clip caches of all media players)
+    FrameCache clip_cache_;
+    static CachePool clip_cache_pool_;
+    gsize clip_budget_;
+    bool clip_enabled_;
+    std::atomic<bool> clip_filling_;
+    std::atomic<bool> clip_overflow_;
+    bool clip_resident_;
+    GstClockTime clip_position_;
+    GstClockTime clip_time_;
+    guint64 clip_hits_;
+    guint64 clip_misses_;
+
     // frame stack
     typedef enum  {
         SAMPLE = 0,
@@ -286,7 +537,6 @@ private:
         FrameStatus status;
         bool full;
         GstClockTime position;
-        std::mutex access;
 
         Frame() {
             full = false;
@@ -294,33 +544,143 @@ private:
             position = GST_CLOCK_TIME_NONE;
         }
     };
-    Frame frame_[N_VFRAME];
+
+    // ring of frames filled by the streaming thread (fill_frame), consumed by update
+    // (pop_frame), or by the upload thread once handed over (worker_upload_), and
+    // emptied by update on seek (release_frames).
+    // NB: not lock-free: when full, the producer drops the oldest frame on the
+    // consumer side (but never a pre-rolled frame), so a lock guards the indices;
+    // it is held only to move frames in and out, never while mapping or uploading
+    // (one slot is always free to distinguish full from empty)
+    std::vector<Frame> frame_;
+    std::mutex queue_lock_;
     guint write_index_;
-    guint last_index_;
-    std::mutex index_lock_;
+    guint read_index_;
+    std::atomic<bool> eos_;
+    std::atomic<guint> dropped_frames_;
+    float queue_occupancy_;
 
     // for PBO
     guint pbo_[2];
     guint pbo_index_, pbo_next_index_;
     guint pbo_size_;
 
+    // for persistent mapped PBO ring (in pbo_[0])
+    guint8 *pbo_map_;
+    void *pbo_fence_[N_PBO_RING]; // GLsync
+
+    // slots of the ring filled by the upload thread
+    typedef enum  {
+        SLOT_FREE = 0,
+        SLOT_FILLED = 1,
+        SLOT_UPLOADING = 2
+    } SlotState;
+    struct PboSlot {
+        std::atomic<int> state;
+        GstClockTime position;
+        guint64 sequence;
+        PboSlot() : state(SLOT_FREE), position(GST_CLOCK_TIME_NONE), sequence(0) {}
+    };
+    PboSlot pbo_slot_[N_PBO_RING];
+    guint64 pbo_sequence_;
+    // true when the upload thread consumes the frame queue
+    std::atomic<bool> worker_upload_;
+
+    // textures of the planes of frames
+    // (plane 0 is the output texture for RGBA frames)
+    guint planes_[3];
+    guint n_planes_;
+    GstVideoInfo v_texture_info_;
+
+    // GPU colorspace conversion for YUV frames
+    // (and deinterlacing of interlaced frames, uploaded as-is)
+    FrameBuffer *yuv_buffer_;
+    Surface *yuv_surface_;
+    VideoShader *yuv_shader_;
+    void init_conversion(const GstVideoInfo *info);
+
+    // deinterlacing: displayed field (bob shows the second field at half the frame duration)
+    // and plane 0 of the previous frame (for motion adaptive)
+    VideoShader::Deinterlace deinterlace_;
+    bool field_tff_;
+    bool field_second_;
+    GstClockTime field_time_;
+    guint previous_plane_;
+    bool previous_valid_; // previous plane holds the frame before (not after open or seek)
+    void set_field(bool second);
+
     // gst pipeline control
     void execute_open();
-    void execute_loop_command();
-    void execute_seek_command(GstClockTime target = GST_CLOCK_TIME_NONE);
+    void execute_bus_messages();
+    void execute_loop_command(bool flush = true);
+    void execute_seek_command(GstClockTime target = GST_CLOCK_TIME_NONE, bool flush = true);
+    void execute_fill_command(GstClockTime start, GstClockTime stop);
 
     // gst frame filling
-    void init_texture(guint index);
-    void fill_texture(guint index);
+    void init_texture(GstVideoFrame *frame);
+    void fill_texture(GstVideoFrame *frame);
+    void upload_planes(GstVideoFrame *frame, bool from_pbo, gsize pbo_offset = 0);
+    bool init_pbo_ring();
+    void free_pbo();
+    bool pop_frame(Frame &frame, const GstVideoInfo *layout = nullptr);
+    void release_frames();
+    void publish_slots();
+    void consume_frames();
+    void convert_texture();
     bool fill_frame(GstBuffer *buf, FrameStatus status);
 
+    // reverse playback and scrubbing from cache
+    bool cache_frames() const;
+    bool cache_reverse_wanted() const;
+    void take_queue();
+    void set_sync(bool on);
+    void update_reverse();
+    bool display_cached_frame(FrameCache &cache, GstClockTime target, GstClockTime tolerance);
+
+    // playback from the clip cache
+    bool clip_cache_wanted() const;
+    void clip_start();
+    void clip_stop();
+    void update_clip();
+
+    // decoding threads: a global budget is shared by enabled media players
+    // (applied to elements with 'max-threads' or 'n-threads' properties,
+    // decoders get the share computed when the media is opened)
+    std::list<GstElement *> threaded_;
+    std::mutex threaded_lock_;
+    std::atomic<guint> threads_;
+    bool decoding() const;
+    void set_threads(guint n);
+    static void rebalance_threads();
+
+    // time spent by the video decoder for each frame
+    std::atomic<GstClockTime> decode_start_;
+    std::atomic<float> decode_time_;
+
     // gst callbacks
+    static void callback_element_added (GstBin *, GstBin *, GstElement *, gpointer);
+    static GstPadProbeReturn callback_decoder_input (GstPad *, GstPadProbeInfo *, gpointer);
+    static GstPadProbeReturn callback_decoder_output (GstPad *, GstPadProbeInfo *, gpointer);
     static void callback_end_of_stream (GstAppSink *, gpointer);
     static GstFlowReturn callback_new_preroll (GstAppSink *, gpointer );
     static GstFlowReturn callback_new_sample  (GstAppSink *, gpointer);
 
+    // upload thread copying frames of all registered media players
+    // into their persistent mapped PBO ring; it takes a reference on
+    // media players while it uses them, and their lock to copy frames
+    void upload_frame();
+    std::mutex upload_lock_;
+    std::atomic<int> upload_refs_;
+    static void upload_worker();
+    static std::thread upload_thread_;
+    static std::atomic<bool> upload_stop_;
+    static std::mutex upload_wait_;
+    static std::condition_variable upload_condition_;
+
     // global list of registered media player
+    // (modified only while holding registry_lock_)
     static std::list<MediaPlayer*> registered_;
+    static std::mutex registry_lock_;
 };
 
 
@@ -10,8 +10,12 @@
 #include "MediaPlayer.h"
 #include "Visitor.h"
 #include "Log.h"
+#include "Mixer.h"
+#include "Session.h"
+#include "FrameBuffer.h"
+#include "RenderingManager.h"
 
-MediaSource::MediaSource() : Source(), path_("")
+MediaSource::MediaSource() : Source(), path_(""), hibernated_resolution_(0.f), transparent_time_(0.f)
 {
     // create media player
     mediaplayer_ = new MediaPlayer;
@@ -119,19 +123,71 @@ void MediaSource::setActive (bool on)
     }
 }
 
+void MediaSource::preroll (bool on)
+{
+    // run the media player before it is enabled
+    mediaplayer_->warm(on);
+}
+
 void MediaSource::update(float dt)
 {
     Source::update(dt);
 
+    // height of the source in the output (or of its largest clone)
+    // a source transparent for a while is displayed with the lowest resolution
+    // (not while it is faded in or out)
+    if ( blendingshader_->color.a > 0.f )
+        transparent_time_ = 0.f;
+    else
+        transparent_time_ += dt;
+    float scale = 0.f;
+    if ( transparent_time_ < SOURCE_TRANSPARENT_DELAY )
+        scale = ABS(groups_[View::RENDERING]->scale_.y);
+    for (auto clone = clones_.begin(); clone != clones_.end(); clone++)
+        scale = MAX( scale, ABS((*clone)->group(View::RENDERING)->scale_.y) );
+    guint height = 0;
+    FrameBuffer *output = Mixer::manager().session()->frame();
+    if (output)
+        height = static_cast<guint>(scale * output->height());
+
+    // height of the source in the view of the main window (e.g. zoomed in the geometry view)
+    View *view = Mixer::manager().view();
+    if ( view && view->mode() != View::RENDERING && groups_.count(view->mode()) > 0 ) {
+        RenderingWindow &window = Rendering::manager().mainWindow();
+        float s = ABS(groups_[view->mode()]->scale_.y * view->scene.root()->scale_.y);
+        height = MAX( height, static_cast<guint>(s * window.height() * window.aspectRatio() / SCENE_UNIT) );
+    }
+    mediaplayer_->setDisplayHeight( MAX(height, 1u) );
+
     // update video
     mediaplayer_->update();
+
+    // hibernating media player: keep only a thumbnail of the last frame
+    if ( initialized_ && mediaplayer_->isHibernating() && hibernated_resolution_.x < 1.f ) {
+        hibernated_resolution_ = renderbuffer_->resolution();
+        uint h = MIN( (uint) SOURCE_THUMBNAIL_HEIGHT, renderbuffer_->height() );
+        renderbuffer_->resize( static_cast<uint>( static_cast<float>(h) * renderbuffer_->aspectRatio() ), h);
+    }
 }
 
 void MediaSource::render()
 {
     if (!initialized_)
         init();
-    else {
+    // render only when the media player has a frame
+    // (otherwise keep the last frame, e.g. when hibernating)
+    else if ( mediaplayer_->texture() != Resource::getTextureBlack() ) {
+
+        // back to full resolution after hibernation
+        // (once the frame at the position it had is shown again)
+        if ( hibernated_resolution_.x > 0.f && !mediaplayer_->isHibernating() && !mediaplayer_->isResuming() ) {
+            renderbuffer_->resize( static_cast<uint>(hibernated_resolution_.x), static_cast<uint>(hibernated_resolution_.y) );
+            hibernated_resolution_ = glm::vec3(0.f);
+        }
+
+        // the texture of the media player changes with its frames
+        mediasurface_->setTextureIndex( mediaplayer_->texture() );
+
         // render the media player into frame buffer
         static glm::mat4 projection = glm::ortho(-1.f, 1.f, 1.f, -1.f, -1.f, 1.f);
         renderbuffer_->begin();
@@ -26,10 +26,18 @@ protected:
 
     void init() override;
     void replaceRenderingShader() override;
+    void preroll(bool on) override;
 
     Surface *mediasurface_;
     std::string path_;
     MediaPlayer *mediaplayer_;
+
+    // full resolution of the frame buffer, while reduced
+    // to a thumbnail during hibernation of the media player
+    glm::vec3 hibernated_resolution_;
+
+    // time since the source is fully transparent (ms)
+    float transparent_time_;
 };
 
 #endif // MEDIASOURCE_H
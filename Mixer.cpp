@@ -22,6 +22,10 @@ using namespace tinyxml2;
 #include "SessionVisitor.h"
 #include "SessionSource.h"
 #include "MediaSource.h"
+#include "ImageSource.h"
+#include "SequenceSource.h"
+#include "MediaPlayer.h"
+#include "Recorder.h"
 
 #include "Mixer.h"
 
@@ -182,6 +186,12 @@ void Mixer::update()
     dt_ = static_cast<float>( GST_TIME_AS_USECONDS(current_time - update_time_) * 0.001f);
     update_time_ = current_time;
 
+    // media are decoded from their originals while recording (proxies are for preview)
+    MediaPlayer::allowProxy( dynamic_cast<VideoRecorder *>(session_->frontRecorder()) == nullptr );
+
+    // release resources of media players disabled for long, if needed
+    MediaPlayer::manageResidency();
+
     // update session and associated sources
     session_->update(dt_);
 
@@ -224,6 +234,13 @@ Source * Mixer::createSourceFile(std::string path)
             ss->load(path);
             s = ss;
         }
+        else if ( ImageSource::supported(path) )
+        {
+            // decode still image without a media player
+            ImageSource *is = new ImageSource;
+            is->setPath(path);
+            s = is;
+        }
         else {
             // (try to) create media source by default
             MediaSource *ms = new MediaSource;
@@ -245,6 +262,27 @@ Source * Mixer::createSourceFile(std::string path)
     return s;
 }
 
+Source * Mixer::createSourceSequence(std::string folder)
+{
+    Source *s = nullptr;
+
+    // sanity check
+    if ( SystemToolkit::file_exists( folder ) ) {
+
+        // create an image sequence source
+        SequenceSource *ss = new SequenceSource;
+        ss->setPath(folder);
+        s = ss;
+
+        // propose a new name based on folder
+        renameSource(s, SystemToolkit::base_filename(folder));
+    }
+    else
+        Log::Notify("Folder %s does not exist.", folder.c_str());
+
+    return s;
+}
+
 Source * Mixer::createSourceRender()
 {
     // ready to create a source
@@ -37,6 +37,7 @@ public:
 
     // creation of sources
     Source * createSourceFile   (std::string path);
+    Source * createSourceSequence (std::string folder);
     Source * createSourceClone  (std::string namesource = "");
     Source * createSourceRender ();
 
@@ -1,4 +1,5 @@
 #include <thread>
+#include <cmath>
 
 //  Desktop OpenGL function loader
 #include <glad/glad.h>
@@ -16,6 +17,8 @@
 #include "defines.h"
 #include "SystemToolkit.h"
 #include "FrameBuffer.h"
+#include "Primitives.h"
+#include "EncodingShader.h"
 #include "Log.h"
 
 #include "Recorder.h"
@@ -25,6 +28,10 @@
 // https://stackoverflow.com/questions/38140527/glreadpixels-vs-glgetteximage
 #define USE_GLREADPIXEL
 
+// pixel buffers held by the appsrc and the encoder (zero-copy), beyond
+// those in transfer and those queued for the encoder
+#define RECORD_READBACK_MARGIN 8
+
 using namespace std;
 
 Recorder::Recorder() : finished_(false), pbo_index_(0), pbo_next_index_(0), size_(0)
@@ -195,31 +202,451 @@ const std::vector<std::string> VideoRecorder::profile_description {
 //               "qtmux ! filesink name=sink";
 
 
+// YUV format produced on GPU for each profile (converted to the format
+// of the encoder by videoconvert when different, e.g. to 10 bits)
+GstVideoFormat VideoRecorder::profile_format(Profile profile)
+{
+    switch (profile) {
+    case H264_HQ:
+    case PRORES_STANDARD:
+    case PRORES_HQ:
+        return GST_VIDEO_FORMAT_Y444;
+    default:
+        return GST_VIDEO_FORMAT_I420;
+    }
+}
+
+const char* VideoRecorder::queue_policy_name[3] = { "Wait encoder", "Drop oldest", "Drop newest" };
+const char* VideoRecorder::framerate_name[6] = { "Match render", "24 fps", "25 fps", "30 fps", "50 fps", "60 fps" };
+const int VideoRecorder::framerate_preset[6] = { 0, 24, 25, 30, 50, 60 };
+
 VideoRecorder::VideoRecorder() : Recorder(), frame_buffer_(nullptr), width_(0), height_(0),
-    recording_(false), accept_buffer_(false), pipeline_(nullptr), src_(nullptr), timestamp_(0)
+    recording_(false), pipeline_(nullptr), src_(nullptr), timestamp_(0),
+    fps_n_(30), fps_d_(1), clock_(GST_CLOCK_TIME_NONE), frames_(0), duplicated_(0), dropped_(0),
+    queue_size_(RECORD_MAX_QUEUE), queue_policy_(QUEUE_DROP_NEWEST), feeding_(false), eos_(false),
+    queue_dropped_(0), queue_blocked_(0), encoded_(0), encoder_fps_(0.f),
+    readback_depth_(0), readback_max_(0), readback_stalls_(0), readback_latency_(0.0), pool_(nullptr),
+    yuv_shader_(nullptr), yuv_surface_(nullptr)
 {
+    for (int p = 0; p < 3; ++p)
+        yuv_framebuffers_[p] = yuv_textures_[p] = 0;
+    gst_video_info_init(&video_info_);
+
+    // configure framerate
+    int f = CLAMP(Settings::application.record.framerate, 0, 5);
+    fps_n_ = framerate_preset[f];
+    frame_duration_ = fps_n_ > 0 ? frame_pts(1) : GST_CLOCK_TIME_NONE;
+
+    // configure queue to encoder
+    queue_size_ = CLAMP(Settings::application.record.queue_size, 1, RECORD_MAX_QUEUE);
+    queue_policy_ = CLAMP(Settings::application.record.queue_policy, QUEUE_BLOCK, QUEUE_DROP_NEWEST);
+}
 
-    // configure fix parameter
-    frame_duration_ = gst_util_uint64_scale_int (1, GST_SECOND, 30);  // 30 FPS
-    timeframe_ = 2 * frame_duration_;
+GstClockTime VideoRecorder::frame_pts(guint64 index) const
+{
+    // exact time of frame at fixed rate, without accumulating rounding
+    return gst_util_uint64_scale (index, GST_SECOND * fps_d_, fps_n_);
 }
 
 VideoRecorder::~VideoRecorder()
 {
+    // abort feeding the encoder
+    {
+        std::lock_guard<std::mutex> lock(queue_lock_);
+        feeding_ = false;
+    }
+    queue_cond_.notify_all();
+
+    // stopping the pipeline also unblocks the appsrc
+    if (pipeline_ != nullptr)
+        gst_element_set_state (pipeline_, GST_STATE_NULL);
+    if (feeder_.joinable())
+        feeder_.join();
+    for (auto it = queue_.begin(); it != queue_.end(); ++it)
+        gst_buffer_unref (*it);
+    queue_.clear();
+
     if (src_ != nullptr)
         gst_object_unref (src_);
-    if (pipeline_ != nullptr) {
-        gst_element_set_state (pipeline_, GST_STATE_NULL);
+    if (pipeline_ != nullptr)
         gst_object_unref (pipeline_);
+
+    // delete pixel buffers (all released by the pipeline stopped above)
+    for (auto it = readback_.begin(); it != readback_.end(); ++it) {
+        if ((*it)->fence)
+            glDeleteSync((GLsync) (*it)->fence);
+        if ((*it)->map) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, (*it)->pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &(*it)->pbo);
+        delete *it;
+    }
+    if (pool_) {
+        gst_buffer_pool_set_active (pool_, FALSE);
+        gst_object_unref (pool_);
     }
 
-    glDeleteBuffers(2, pbo_);
+    // delete GPU conversion
+    if (yuv_surface_)
+        delete yuv_surface_;
+    glDeleteFramebuffers(3, yuv_framebuffers_);
+    glDeleteTextures(3, yuv_textures_);
 }
 
-void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
+void VideoRecorder::init_readback(guint depth)
+{
+    readback_depth_ = depth;
+    readback_max_ = readback_depth_ + queue_size_ + RECORD_READBACK_MARGIN;
+
+    // create the pixel buffers for the transfers in progress
+    for (guint i = 0; i < readback_depth_; ++i) {
+        Readback *r = new_readback();
+        if (r == nullptr)
+            break;
+        readback_free_.push_back(r);
+    }
+
+    // without persistent mapping, frames are copied into pre-allocated buffers
+    if ( readback_.empty() || readback_.front()->map == nullptr ) {
+        pool_ = gst_buffer_pool_new ();
+        GstStructure *config = gst_buffer_pool_get_config (pool_);
+        gst_buffer_pool_config_set_params (config, NULL, size_, readback_depth_, 0);
+        gst_buffer_pool_set_config (pool_, config);
+        gst_buffer_pool_set_active (pool_, TRUE);
+    }
+}
+
+VideoRecorder::Readback *VideoRecorder::new_readback()
+{
+    if ( readback_.size() >= readback_max_ )
+        return nullptr;
+
+    Readback *r = new Readback;
+    r->recorder = this;
+    r->map = nullptr;
+    r->fence = nullptr;
+    r->pts = 0;
+    r->issued = 0;
+
+    glGenBuffers(1, &r->pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r->pbo);
+    // persistent mapping requires ARB_buffer_storage (core in OpenGL 4.4):
+    // the memory is pushed to the encoder without copy
+    if ( GLAD_GL_ARB_buffer_storage && (readback_.empty() || readback_.front()->map != nullptr) ) {
+        GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, size_, 0, flags);
+        r->map = (guint8 *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size_, flags);
+        if (r->map == nullptr) {
+            // did not work, use copy to buffers
+            glDeleteBuffers(1, &r->pbo);
+            glGenBuffers(1, &r->pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, r->pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size_, NULL, GL_STREAM_READ);
+        }
+    }
+    else
+        glBufferData(GL_PIXEL_PACK_BUFFER, size_, NULL, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback_.push_back(r);
+    return r;
+}
+
+bool VideoRecorder::issue_readback(FrameBuffer *frame_buffer, GstClockTime pts, guint64 frame, guint repeat)
+{
+    // ring full: wait for the oldest transfer (should not happen if deep enough)
+    if ( readback_pending_.size() >= readback_depth_ ) {
+        ++readback_stalls_;
+        complete_readback(true);
+    }
+
+    // get a pixel buffer which is not in transfer nor held by the encoder
+    // (never waiting for the encoder to release one: rendering goes on)
+    Readback *r = acquire_readback();
+
+    // all held by the encoder: drop the oldest frames queued if the policy allows,
+    // otherwise this frame is dropped
+    if ( r == nullptr && queue_policy_ == QUEUE_DROP_OLDEST ) {
+        while ( r == nullptr && drop_queued() )
+            r = acquire_readback();
+    }
+    if ( r == nullptr )
+        return false;
+
+    // set buffer target for writing in a new frame
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r->pbo);
+
+    // get frame converted in YUV planes
+    if (yuv_surface_)
+        convert_frame(frame_buffer);
+    else {
+#ifdef USE_GLREADPIXEL
+        // get frame
+        frame_buffer->readPixels();
+#else
+        glBindTexture(GL_TEXTURE_2D, frame_buffer->texture());
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+#endif
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // fence signaled when the transfer is done
+    r->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    r->pts = pts;
+    r->frame = frame;
+    r->repeat = repeat;
+    r->issued = gst_util_get_timestamp ();
+    readback_pending_.push_back(r);
+
+    return true;
+}
+
+bool VideoRecorder::complete_readback(bool wait)
 {
-    // TODO : avoid software videoconvert by using a GPU shader to produce Y444 frames
+    if ( readback_pending_.empty() )
+        return false;
+
+    // oldest transfer in progress
+    Readback *r = readback_pending_.front();
+
+    // test (or wait for) the end of transfer
+    GLenum ret = glClientWaitSync((GLsync) r->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                  wait ? GL_TIMEOUT_IGNORED : 0);
+    if ( ret != GL_ALREADY_SIGNALED && ret != GL_CONDITION_SATISFIED && ret != GL_WAIT_FAILED )
+        return false;
+    glDeleteSync((GLsync) r->fence);
+    r->fence = nullptr;
+    readback_pending_.pop_front();
+
+    // measure readback latency
+    double latency = gst_guint64_to_gdouble( GST_TIME_AS_USECONDS(gst_util_get_timestamp () - r->issued) ) / 1000.0;
+    readback_latency_ = readback_latency_ > 0.0 ? 0.9 * readback_latency_ + 0.1 * latency : latency;
+
+    GstBuffer *buffer = nullptr;
+
+    // zero-copy: wrap the mapped memory, given back when the encoder releases the buffer
+    if (r->map) {
+        buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, r->map, size_, 0, size_,
+                                              r, VideoRecorder::release_readback);
+    }
+    // copy into a buffer of the pool
+    else {
+        if ( gst_buffer_pool_acquire_buffer (pool_, &buffer, NULL) != GST_FLOW_OK )
+            buffer = gst_buffer_new_and_alloc (size_);
+
+        // map gst buffer into a memory  WRITE target
+        GstMapInfo map;
+        gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+
+        // map PBO pixels into a memory READ pointer
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, r->pbo);
+        unsigned char* ptr = (unsigned char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+        // transfer pixels from PBO memory to buffer memory
+        if (NULL != ptr)
+            memmove(map.data, ptr, size_);
+
+        // un-map
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        gst_buffer_unmap (buffer, &map);
 
+        // pixel buffer is available again
+        release_readback(r);
+    }
+
+    // push the frame in each recording slot it fills
+    // (duplicates are copies sharing the memory of the buffer)
+    for (guint i = 0; i < r->repeat; ++i) {
+        GstBuffer *b = i + 1 < r->repeat ? gst_buffer_copy (buffer) : buffer;
+
+        // set timing of buffer
+        b->pts = i > 0 ? frame_pts(r->frame + i) : r->pts;
+        b->duration = frame_duration_;
+
+        // queue for the encoder
+        feed(b);
+    }
+
+    return true;
+}
+
+VideoRecorder::Readback *VideoRecorder::acquire_readback()
+{
+    std::lock_guard<std::mutex> lock(readback_lock_);
+
+    // the encoder holds more frames than the ring: add a buffer (up to the maximum)
+    if ( readback_free_.empty() )
+        return new_readback();
+
+    Readback *r = readback_free_.front();
+    readback_free_.pop_front();
+    return r;
+}
+
+bool VideoRecorder::drop_queued()
+{
+    GstBuffer *buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(queue_lock_);
+        if ( queue_.empty() )
+            return false;
+        buffer = queue_.front();
+        queue_.pop_front();
+        ++queue_dropped_;
+    }
+    queue_cond_.notify_all();
+
+    // NB: releases its pixel buffer (zero-copy) unless duplicates share it
+    gst_buffer_unref (buffer);
+    return true;
+}
+
+void VideoRecorder::feed(GstBuffer *buffer)
+{
+    std::unique_lock<std::mutex> lock(queue_lock_);
+
+    // queue full: encoder is too slow
+    if ( queue_.size() >= queue_size_ ) {
+        if ( queue_policy_ == QUEUE_DROP_NEWEST ) {
+            ++queue_dropped_;
+            gst_buffer_unref (buffer);
+            return;
+        }
+        else if ( queue_policy_ == QUEUE_DROP_OLDEST ) {
+            ++queue_dropped_;
+            gst_buffer_unref (queue_.front());
+            queue_.pop_front();
+        }
+        else {
+            // wait for the encoder (blocks rendering)
+            ++queue_blocked_;
+            queue_cond_.wait(lock, [&]{ return queue_.size() < queue_size_ || !feeding_; });
+        }
+    }
+
+    queue_.push_back(buffer);
+    lock.unlock();
+    queue_cond_.notify_all();
+}
+
+guint VideoRecorder::queueDepth()
+{
+    std::lock_guard<std::mutex> lock(queue_lock_);
+    return queue_.size();
+}
+
+void VideoRecorder::feed_encoder()
+{
+    guint64 count = 0;
+    GstClockTime start = gst_util_get_timestamp ();
+
+    std::unique_lock<std::mutex> lock(queue_lock_);
+    while (feeding_) {
+
+        queue_cond_.wait(lock, [&]{ return !queue_.empty() || eos_ || !feeding_; });
+        if (!feeding_)
+            break;
+
+        // all frames given: end of stream
+        if (queue_.empty()) {
+            lock.unlock();
+            gst_app_src_end_of_stream (src_);
+            return;
+        }
+
+        GstBuffer *buffer = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+        queue_cond_.notify_all();
+
+        // push (blocks while the appsrc is full)
+        gst_app_src_push_buffer (src_, buffer);
+        // NB: buffer will be unrefed by the appsrc
+
+        // measure the rate of the encoder
+        ++encoded_;
+        ++count;
+        GstClockTime now = gst_util_get_timestamp ();
+        if ( now - start > GST_SECOND ) {
+            encoder_fps_ = (float) count * GST_SECOND / (float) (now - start);
+            count = 0;
+            start = now;
+        }
+
+        lock.lock();
+    }
+}
+
+// pixel buffer memory released (called by gstreamer for wrapped memory)
+void VideoRecorder::release_readback(gpointer data)
+{
+    Readback *r = (Readback *) data;
+    std::lock_guard<std::mutex> lock(r->recorder->readback_lock_);
+    r->recorder->readback_free_.push_back(r);
+}
+
+void VideoRecorder::init_conversion(GstVideoFormat format)
+{
+    // layout of the planes in memory (as expected by gstreamer)
+    gst_video_info_set_format(&video_info_, format, width_, height_);
+    gst_video_colorimetry_from_string(&video_info_.colorimetry, GST_VIDEO_COLORIMETRY_BT709);
+
+    // one frame buffer per plane, sized by the subsampling of the format
+    glGenTextures(3, yuv_textures_);
+    glGenFramebuffers(3, yuv_framebuffers_);
+    for (guint p = 0; p < GST_VIDEO_INFO_N_PLANES(&video_info_); ++p) {
+        glBindTexture(GL_TEXTURE_2D, yuv_textures_[p]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, GST_VIDEO_INFO_COMP_WIDTH(&video_info_, p),
+                       GST_VIDEO_INFO_COMP_HEIGHT(&video_info_, p));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, yuv_framebuffers_[p]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, yuv_textures_[p], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    FrameBuffer::release();
+
+    // surface to draw the frame buffer of the session with the conversion shader
+    yuv_shader_ = new EncodingShader;
+    yuv_surface_ = new Surface(yuv_shader_);
+
+    // size of the frames to read back
+    size_ = GST_VIDEO_INFO_SIZE(&video_info_);
+}
+
+void VideoRecorder::convert_frame(FrameBuffer *frame_buffer)
+{
+    static glm::mat4 identity(1.f);
+    yuv_surface_->setTextureIndex( frame_buffer->texture() );
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (guint p = 0; p < GST_VIDEO_INFO_N_PLANES(&video_info_); ++p) {
+
+        // render the plane
+        RenderingAttrib attrib;
+        attrib.viewport = glm::ivec2(GST_VIDEO_INFO_COMP_WIDTH(&video_info_, p), GST_VIDEO_INFO_COMP_HEIGHT(&video_info_, p));
+        attrib.clear_color = glm::vec4(0.f);
+        glBindFramebuffer(GL_FRAMEBUFFER, yuv_framebuffers_[p]);
+        Rendering::manager().pushAttrib(attrib);
+        yuv_shader_->plane = (EncodingShader::Plane) p;
+        yuv_surface_->draw(identity, identity);
+        Rendering::manager().popAttrib();
+
+        // read the plane at its offset in the pixel buffer (bound by caller)
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, yuv_framebuffers_[p]);
+        glPixelStorei(GL_PACK_ROW_LENGTH, GST_VIDEO_INFO_PLANE_STRIDE(&video_info_, p));
+        glReadPixels(0, 0, attrib.viewport.x, attrib.viewport.y, GL_RED, GL_UNSIGNED_BYTE,
+                     (void *) GST_VIDEO_INFO_PLANE_OFFSET(&video_info_, p));
+    }
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    FrameBuffer::release();
+}
+
+void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
+{
     // ignore
     if (frame_buffer == nullptr)
         return;
@@ -235,17 +662,19 @@ void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
        height_ = frame_buffer_->height();
        size_ = width_ * height_ * (frame_buffer_->use_alpha() ? 4 : 3);
 
-       // create PBOs
-       glGenBuffers(2, pbo_);
-       glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[1]);
-       glBufferData(GL_PIXEL_PACK_BUFFER, size_, NULL, GL_STREAM_READ);
-       glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[0]);
-       glBufferData(GL_PIXEL_PACK_BUFFER, size_, NULL, GL_STREAM_READ);
+       if (Settings::application.record.profile < 0 || Settings::application.record.profile >= DEFAULT)
+           Settings::application.record.profile = H264_STANDARD;
+
+       // convert frames on GPU to the YUV format of the encoder
+       // (reads back half of RGB for 4:2:0 and saves conversion on CPU)
+       if (Settings::application.render.gpu_colorspace)
+           init_conversion( profile_format( (Profile) Settings::application.record.profile) );
+
+       // create ring of PBOs
+       init_readback( CLAMP(Settings::application.record.readback_depth, 2, RECORD_MAX_READBACK) );
 
        // create a gstreamer pipeline
        string description = "appsrc name=src ! videoconvert ! ";
-       if (Settings::application.record.profile < 0 || Settings::application.record.profile >= DEFAULT)
-           Settings::application.record.profile = H264_STANDARD;
        description += profile_description[Settings::application.record.profile];
 
        // verify location path (path is always terminated by the OS dependent separator)
@@ -296,27 +725,28 @@ void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
                          //                     "do-timestamp", TRUE,
                          NULL);
 
-           // Direct encoding (no buffering)
-           gst_app_src_set_max_bytes( src_, 0 );
-//           gst_app_src_set_max_bytes( src_, 2 * buf_size_);
+           // Direct encoding: the feeding thread blocks when the
+           // appsrc holds more than a frame (frames wait in our queue)
+           gst_app_src_set_max_bytes( src_, size_ );
+           g_object_set (G_OBJECT (src_), "block", TRUE, NULL);
 
            // instruct src to use the required caps
-           GstCaps *caps = gst_caps_new_simple ("video/x-raw",
+           GstCaps *caps = nullptr;
+           if (yuv_surface_) {
+               GST_VIDEO_INFO_FPS_N(&video_info_) = fps_n_;
+               GST_VIDEO_INFO_FPS_D(&video_info_) = fps_d_;
+               caps = gst_video_info_to_caps(&video_info_);
+           }
+           else
+               caps = gst_caps_new_simple ("video/x-raw",
                                 "format", G_TYPE_STRING, frame_buffer_->use_alpha() ? "RGBA" : "RGB",
                                 "width",  G_TYPE_INT, width_,
                                 "height", G_TYPE_INT, height_,
-                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                "framerate", GST_TYPE_FRACTION, fps_n_, fps_d_,
                                 NULL);
            gst_app_src_set_caps (src_, caps);
            gst_caps_unref (caps);
 
-           // setup callbacks
-           GstAppSrcCallbacks callbacks;
-           callbacks.need_data = callback_need_data;
-           callbacks.enough_data = callback_enough_data;
-           callbacks.seek_data = NULL; // stream type is not seekable
-           gst_app_src_set_callbacks (src_, &callbacks, this, NULL);
-
        }
        else {
            Log::Warning("VideoRecorder Could not configure capture source");
@@ -335,6 +765,10 @@ void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
        // all good
        Log::Info("VideoRecorder start recording (%s %d x %d)", profile_name[Settings::application.record.profile], width_, height_);
 
+       // start feeding the encoder
+       feeding_ = true;
+       feeder_ = std::thread(&VideoRecorder::feed_encoder, this);
+
        // start recording !!
        recording_ = true;
    }
@@ -358,69 +792,37 @@ void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
    // store a frame if recording is active
    if (recording_ && size_ > 0)
    {
-       // calculate dt in ns
-       timeframe_ +=  gst_gdouble_to_guint64( dt * 1000000.f);
-
-       // if time is passed one frame duration (with 10% margin)
-       // and if the encoder accepts data
-       if ( timeframe_ > frame_duration_ - 3000000 && accept_buffer_) {
-
-           // set buffer target for writing in a new frame
-           glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_index_]);
-
-#ifdef USE_GLREADPIXEL
-           // get frame
-           frame_buffer->readPixels();
-#else
-           glBindTexture(GL_TEXTURE_2D, frame_buffer->texture());
-           glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-#endif
-
-           // update case ; alternating indices
-           if ( pbo_next_index_ != pbo_index_ ) {
-
-               // set buffer target for saving the frame
-               glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_next_index_]);
-
-               // new buffer
-               GstBuffer *buffer = gst_buffer_new_and_alloc (size_);
-
-               // set timing of buffer
-               buffer->pts = timestamp_;
-               buffer->duration = frame_duration_;
-
-               // map gst buffer into a memory  WRITE target
-               GstMapInfo map;
-               gst_buffer_map (buffer, &map, GST_MAP_WRITE);
-
-               // map PBO pixels into a memory READ pointer
-               unsigned char* ptr = (unsigned char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-
-               // transfer pixels from PBO memory to buffer memory
-               if (NULL != ptr)
-                   memmove(map.data, ptr, size_);
-
-               // un-map
-               glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-               gst_buffer_unmap (buffer, &map);
-
-               // push
-    //           Log::Info("VideoRecorder push data %ld", buffer->pts);
-               gst_app_src_push_buffer (src_, buffer);
-               // NB: buffer will be unrefed by the appsrc
-
-               // next timestamp
-               timestamp_ += frame_duration_;
+       // advance clock of the mixer (dt is in milisecond, measured in micro seconds)
+       if (clock_ == GST_CLOCK_TIME_NONE)
+           clock_ = 0;
+       else
+           clock_ += gst_gdouble_to_guint64( round(dt * 1000.0) ) * GST_USECOND;
+
+       // push the frames which readback is complete
+       while ( complete_readback(false) );
+
+       // match render: record every frame at the time it was rendered
+       if (fps_n_ < 1) {
+           if ( issue_readback(frame_buffer, clock_, 0, 1) )
+               timestamp_ = clock_;
+           else
+               ++dropped_;
+       }
+       // fixed rate: record the frame in the recording slots passed
+       else {
+           guint64 due = gst_util_uint64_scale (clock_, fps_n_, GST_SECOND * fps_d_) + 1;
+           if ( due > frames_ ) {
+               guint repeat = (guint) (due - frames_);
+               // transfer frame asynchronously
+               // (all the recording slots are lost if it cannot)
+               if ( issue_readback(frame_buffer, frame_pts(frames_), frames_, repeat) )
+                   duplicated_ += repeat - 1;
+               else
+                   dropped_ += repeat;
+               frames_ = due;
+               timestamp_ = frame_pts(frames_);
            }
-
-           glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-           // alternate indices
-           pbo_next_index_ = pbo_index_;
-           pbo_index_ = (pbo_index_ + 1) % 2;
-
-           // restart frame counter
-           timeframe_ = 0;
+           // rendering faster than recording: no slot for this frame (not a drop)
        }
 
    }
@@ -448,9 +850,15 @@ void VideoRecorder::addFrame (FrameBuffer *frame_buffer, float dt)
 
 void VideoRecorder::stop ()
 {
-    // send end of stream
-    gst_app_src_end_of_stream (src_);
-//    Log::Info("VideoRecorder push EOS");
+    // push the frames still in transfer
+    while ( complete_readback(true) );
+
+    // send end of stream after the frames queued
+    {
+        std::lock_guard<std::mutex> lock(queue_lock_);
+        eos_ = true;
+    }
+    queue_cond_.notify_all();
 
     // stop recording
     recording_ = false;
@@ -458,8 +866,18 @@ void VideoRecorder::stop ()
 
 std::string VideoRecorder::info()
 {
-    if (recording_)
-        return GstToolkit::time_to_string(timestamp_);
+    if (recording_) {
+        char buf[64];
+        snprintf(buf, 64, "  (%.0f ms readback", readback_latency_);
+        std::string text = GstToolkit::time_to_string(timestamp_) + buf;
+        if (readback_stalls_ > 0)
+            text += ", " + std::to_string(readback_stalls_) + " stalls";
+        if (duplicated_ > 0)
+            text += ", " + std::to_string(duplicated_) + " dup";
+        if (dropped_ + queue_dropped_ > 0)
+            text += ", " + std::to_string(dropped_ + queue_dropped_) + " drop";
+        return text + ")";
+    }
     else
         return "Saving file...";
 }
@@ -469,24 +887,3 @@ double VideoRecorder::duration()
 {
     return gst_guint64_to_gdouble( GST_TIME_AS_MSECONDS(timestamp_) ) / 1000.0;
 }
-
-// appsrc needs data and we should start sending
-void VideoRecorder::callback_need_data (GstAppSrc *, guint , gpointer p)
-{
-//    Log::Info("H264Recording callback_need_data");
-    VideoRecorder *rec = (VideoRecorder *)p;
-    if (rec) {
-        rec->accept_buffer_ = rec->recording_ ? true : false;
-    }
-}
-
-// appsrc has enough data and we can stop sending
-void VideoRecorder::callback_enough_data (GstAppSrc *, gpointer p)
-{
-//    Log::Info("H264Recording callback_enough_data");
-    VideoRecorder *rec = (VideoRecorder *)p;
-    if (rec) {
-        rec->accept_buffer_ = false;
-    }
-}
-
@@ -4,11 +4,19 @@
 #include <atomic>
 #include <string>
 #include <vector>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include <gst/pbutils/pbutils.h>
 #include <gst/app/gstappsrc.h>
+#include <gst/video/video.h>
 
 class FrameBuffer;
+class Surface;
+class EncodingShader;
 
 /**
  * @brief The Recorder class defines the base class for all recorders
@@ -62,17 +70,78 @@ class VideoRecorder : public Recorder
 
     // operation
     std::atomic<bool> recording_;
-    std::atomic<bool> accept_buffer_;
 
     // gstreamer pipeline
     GstElement   *pipeline_;
     GstAppSrc    *src_;
-    GstClockTime timeframe_;
     GstClockTime timestamp_;
     GstClockTime frame_duration_;
 
-    static void callback_need_data (GstAppSrc *, guint, gpointer user_data);
-    static void callback_enough_data (GstAppSrc *, gpointer user_data);
+    // frame pacing: recording slots at fixed rate on the clock of the mixer,
+    // filled with the latest frame rendered (duplicated if rendering is slower,
+    // frames skipped if faster) or every frame at its time to match render
+    gint fps_n_, fps_d_;      // 0 to match render (variable framerate)
+    GstClockTime clock_;      // time of mixer since start of recording
+    guint64 frames_;          // recording slots passed
+    guint64 duplicated_;
+    guint64 dropped_;         // recording slots lost (frame not read back)
+    GstClockTime frame_pts(guint64 index) const;
+
+    // encoder feeding thread: frames read back are queued and pushed to
+    // the appsrc by this thread (blocking while the encoder is busy)
+    std::thread feeder_;
+    std::deque<GstBuffer *> queue_;
+    std::mutex queue_lock_;
+    std::condition_variable queue_cond_;
+    guint queue_size_;
+    int queue_policy_;
+    bool feeding_;   // false to abort
+    bool eos_;       // end of stream after the frames queued
+    std::atomic<guint64> queue_dropped_;
+    std::atomic<guint64> queue_blocked_;
+    std::atomic<guint64> encoded_;
+    std::atomic<float> encoder_fps_;
+    void feed(GstBuffer *buffer);
+    bool drop_queued();
+    void feed_encoder();
+
+    // asynchronous readback: pixel buffers in transfer, each one read
+    // only once the fence following its transfer has signaled
+    struct Readback {
+        VideoRecorder *recorder;
+        guint pbo;
+        guint8 *map; // persistent mapping, wrapped in the buffers pushed
+        void *fence; // GLsync
+        GstClockTime pts;
+        guint64 frame;  // recording slot (fixed framerate)
+        guint repeat;   // number of recording slots filled by this frame
+        GstClockTime issued;
+    };
+    std::vector<Readback *> readback_;        // all pixel buffers
+    std::deque<Readback *> readback_pending_; // in transfer, oldest first
+    std::list<Readback *> readback_free_;     // available for transfer
+    std::mutex readback_lock_;
+    guint readback_depth_;   // maximum transfers in progress
+    guint readback_max_;     // maximum pixel buffers, in transfer or held by the encoder
+    guint readback_stalls_;  // times the ring was full and the oldest awaited
+    double readback_latency_;// average time between transfer and mapping (ms)
+    GstBufferPool *pool_;    // buffers to copy into, without persistent mapping
+    void init_readback(guint depth);
+    Readback *new_readback();
+    Readback *acquire_readback();
+    bool issue_readback(FrameBuffer *frame_buffer, GstClockTime pts, guint64 frame, guint repeat);
+    bool complete_readback(bool wait);
+    static void release_readback(gpointer data);
+
+    // GPU conversion of frames into the YUV format of the encoder
+    // (one single channel frame buffer per plane, read back in the PBO)
+    GstVideoInfo video_info_;
+    EncodingShader *yuv_shader_;
+    Surface *yuv_surface_;
+    guint yuv_framebuffers_[3];
+    guint yuv_textures_[3];
+    void init_conversion(GstVideoFormat format);
+    void convert_frame(FrameBuffer *frame_buffer);
 
 public:
 
@@ -88,7 +157,17 @@ public:
         DEFAULT
     } Profile;
     static const char* profile_name[DEFAULT];
+    static const char* framerate_name[6];
+    static const int framerate_preset[6];
     static const std::vector<std::string> profile_description;
+    static GstVideoFormat profile_format(Profile profile);
+
+    typedef enum {
+        QUEUE_BLOCK = 0,
+        QUEUE_DROP_OLDEST,
+        QUEUE_DROP_NEWEST
+    } QueuePolicy;
+    static const char* queue_policy_name[3];
 
     VideoRecorder();
     ~VideoRecorder();
@@ -98,6 +177,19 @@ public:
     std::string info() override;
 
     double duration() override;
+    inline guint stalls() const { return readback_stalls_; }
+    inline bool zeroCopy() const { return pool_ == nullptr; }
+    inline guint64 duplicated() const { return duplicated_; }
+    inline guint64 dropped() const { return dropped_; }
+    inline double latency() const { return readback_latency_; }
+
+    // encoder feeding
+    guint queueDepth();
+    inline guint queueSize() const { return queue_size_; }
+    inline guint64 queueDropped() const { return queue_dropped_; }
+    inline guint64 queueBlocked() const { return queue_blocked_; }
+    inline float encoderFramerate() const { return encoder_fps_; }
+    inline guint64 encoded() const { return encoded_; }
 
 };
 
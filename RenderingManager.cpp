@@ -46,6 +46,7 @@
 #include "Primitives.h"
 #include "Mixer.h"
 #include "SystemToolkit.h"
+#include "GstToolkit.h"
 #include "UserInterfaceManager.h"
 #include "RenderingManager.h"
 
@@ -156,23 +157,38 @@ bool Rendering::init()
     g_setenv ("GST_GL_API", "opengl3", TRUE);
     gst_init (NULL, NULL);
 
+    // prefer the decoders which performed best on this computer
+    if ( !Settings::application.media.decoders.empty() ) {
+        GstToolkit::apply_decoders_ranking(Settings::application.media.decoders);
+        Log::Info("Applied ranking of video decoders for %d codec(s).", (int) Settings::application.media.decoders.size());
+    }
 
-//#if GST_GL_HAVE_PLATFORM_WGL
-//    global_gl_context = gst_gl_context_new_wrapped (display, (guintptr) wglGetCurrentContext (),
-//                                                    GST_GL_PLATFORM_WGL, GST_GL_API_OPENGL);
-//#elif GST_GL_HAVE_PLATFORM_CGL
-////    global_display = GST_GL_DISPLAY ( glfwGetCocoaMonitor(main_.window()) );
-//    global_display = GST_GL_DISPLAY (gst_gl_display_cocoa_new ());
 
-//    global_gl_context = gst_gl_context_new_wrapped (global_display,
-//                                         (guintptr) 0,
-//                                         GST_GL_PLATFORM_CGL, GST_GL_API_OPENGL);
-//#elif GST_GL_HAVE_PLATFORM_GLX
-//    global_display = (GstGLDisplay*) gst_gl_display_x11_new_with_display( glfwGetX11Display() );
-//    global_gl_context = gst_gl_context_new_wrapped (global_display,
-//                                        (guintptr) glfwGetGLXContext(main_.window()),
-//                                        GST_GL_PLATFORM_GLX, GST_GL_API_OPENGL);
-//#endif
+    //
+    // Share the OpenGL context of the main window with gstreamer
+    // (allows pipelines to decode directly into textures)
+    //
+#if defined(GLFW_EXPOSE_NATIVE_GLX) && GST_GL_HAVE_PLATFORM_GLX
+    global_display = (GstGLDisplay*) gst_gl_display_x11_new_with_display( glfwGetX11Display() );
+    global_gl_context = gst_gl_context_new_wrapped (global_display,
+                                        (guintptr) glfwGetGLXContext(main_.window()),
+                                        GST_GL_PLATFORM_GLX, GST_GL_API_OPENGL3);
+#endif
+    // NB: wrapping the CGL context is not working under OSX ; media players use system memory
+
+    if (global_gl_context) {
+        // the context of the main window is current: gstreamer can query its properties
+        GError *error = NULL;
+        gst_gl_context_activate (global_gl_context, TRUE);
+        if ( !gst_gl_context_fill_info (global_gl_context, &error) ) {
+            Log::Info("Cannot share OpenGL context with GStreamer: %s", error ? error->message : "");
+            g_clear_error (&error);
+            gst_object_unref (global_gl_context);
+            global_gl_context = NULL;
+        }
+        else
+            Log::Info("OpenGL context shared with GStreamer.");
+    }
 
 
     //
@@ -264,6 +280,17 @@ void Rendering::draw()
 
 void Rendering::terminate()
 {
+    // release gstreamer opengl context
+    if (global_gl_context) {
+        gst_gl_context_activate (global_gl_context, FALSE);
+        gst_object_unref (global_gl_context);
+        global_gl_context = NULL;
+    }
+    if (global_display) {
+        gst_object_unref (global_display);
+        global_display = NULL;
+    }
+
     // close window
     glfwDestroyWindow(output_.window());
     glfwDestroyWindow(main_.window());
@@ -778,11 +805,10 @@ void RenderingWindow::draw(FrameBuffer *fb)
 }
 
 
-//
-// Discarded because not working under OSX - kept in case it would become useful
 //
 // Linking pipeline to the rendering instance ensures the opengl contexts
-// created by gstreamer inside plugins (e.g. glsinkbin) is the same
+// created by gstreamer inside plugins (e.g. glupload) are shared with
+// the context of the main window (NB: not working under OSX)
 //
 
 static GstBusSyncReply
@@ -809,11 +835,18 @@ bus_sync_handler (GstBus *, GstMessage * msg, gpointer )
 
             g_info ("Managed %s\n", contextType);
         }
+
+        gst_message_unref (msg);
+        return GST_BUS_DROP;
     }
 
-    gst_message_unref (msg);
+    // all other messages are posted on the bus
+    return GST_BUS_PASS;
+}
 
-    return GST_BUS_DROP;
+bool Rendering::glContextShared() const
+{
+    return global_gl_context != NULL;
 }
 
 void Rendering::LinkPipeline( GstPipeline *pipeline )
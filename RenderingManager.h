@@ -130,6 +130,11 @@ public:
     // get Screenshot
     class Screenshot *currentScreenshot();
 
+    // for opengl pipeline in gstreamer: true if gstreamer can share the OpenGL context
+    bool glContextShared() const;
+    // capture context requests of the gstreamer pipeline to share the OpenGL context
+    void LinkPipeline( GstPipeline *pipeline );
+
     // get projection matrix (for sharers) => Views
     glm::mat4 Projection();
     // unproject from window coordinate to scene
@@ -155,9 +160,6 @@ private:
 
     Screenshot screenshot_;
     bool request_screenshot_;
-
-    // for opengl pipeline in gstreamer
-    void LinkPipeline( GstPipeline *pipeline );
 };
 
 
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <cctype>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "SequenceSource.h"
+
+#include "defines.h"
+#include "ImageShader.h"
+#include "FrameBuffer.h"
+#include "Resource.h"
+#include "Primitives.h"
+#include "Decorations.h"
+#include "SystemToolkit.h"
+#include "Visitor.h"
+#include "Log.h"
+
+// order of file names, with numbers compared by value (e.g. 'img_9.png' before 'img_10.png')
+static bool NaturalOrder_(const std::string &a, const std::string &b)
+{
+    size_t i = 0, j = 0;
+    while ( i < a.size() && j < b.size() ) {
+        if ( std::isdigit((unsigned char) a[i]) && std::isdigit((unsigned char) b[j]) ) {
+            // numbers without their leading zeros
+            while ( i < a.size() && a[i] == '0' ) ++i;
+            while ( j < b.size() && b[j] == '0' ) ++j;
+            size_t ei = i, ej = j;
+            while ( ei < a.size() && std::isdigit((unsigned char) a[ei]) ) ++ei;
+            while ( ej < b.size() && std::isdigit((unsigned char) b[ej]) ) ++ej;
+            // more digits is a larger number, otherwise compare digits
+            if ( ei - i != ej - j )
+                return ei - i < ej - j;
+            int c = a.compare(i, ei - i, b, j, ej - j);
+            if ( c != 0 )
+                return c < 0;
+            i = ei;
+            j = ej;
+        }
+        else {
+            if ( a[i] != b[j] )
+                return a[i] < b[j];
+            ++i;
+            ++j;
+        }
+    }
+    return a.size() - i < b.size() - j;
+}
+
+SequenceSource::SequenceSource() : Source(), path_(""), textureindex_(0), width_(0), height_(0),
+    position_(0), framerate_(SEQUENCE_DEFAULT_FPS), speed_(1.0), playing_(true), loop_(true),
+    displayed_(0), stop_(true)
+{
+    failed_ = false;
+
+    // create sequence surface:
+    // - textured with the texture of the current image
+    // - crop & repeat UV can be managed here
+    // - additional custom shader can be associated
+    sequencesurface_ = new Surface(renderingshader_);
+}
+
+SequenceSource::~SequenceSource()
+{
+    // end decoding threads
+    stop_workers();
+
+    // free prefetched frames
+    for (auto it = ring_.begin(); it != ring_.end(); ++it)
+        stbi_image_free(it->second.pixels);
+    ring_.clear();
+
+    // delete surface
+    delete sequencesurface_;
+
+    // delete texture
+    if (textureindex_)
+        glDeleteTextures(1, &textureindex_);
+}
+
+void SequenceSource::setPath(const std::string &folder)
+{
+    stop_workers();
+
+    path_ = folder;
+    files_.clear();
+    for (auto it = ring_.begin(); it != ring_.end(); ++it)
+        stbi_image_free(it->second.pixels);
+    ring_.clear();
+    unreadable_.clear();
+
+    // list images of the folder, keeping the most frequent extension
+    static const char *extensions[] = { "png", "jpg", "jpeg", "tga", "bmp", "PNG", "JPG", "JPEG", "TGA", "BMP" };
+    for (auto ext : extensions) {
+        std::list<std::string> ls = SystemToolkit::list_directory(path_, ext);
+        if (ls.size() > files_.size())
+            files_ = std::vector<std::string>(ls.begin(), ls.end());
+    }
+
+    if (files_.empty()) {
+        Log::Warning("No image sequence in folder %s", path_.c_str());
+        failed_ = true;
+        return;
+    }
+
+    // numbered files are played in the order of their numbers (padded or not)
+    std::sort(files_.begin(), files_.end(), NaturalOrder_);
+
+    // timing of the sequence
+    setFramerate(framerate_);
+    position_ = 0;
+    displayed_ = 0;
+
+    // start prefetching frames
+    start_workers();
+    prefetch(0);
+
+    Log::Notify("Opening image sequence %s (%d frames)", path_.c_str(), files_.size());
+}
+
+std::string SequenceSource::path() const
+{
+    return path_;
+}
+
+size_t SequenceSource::numFrames() const
+{
+    return files_.size();
+}
+
+void SequenceSource::setFramerate(double fps)
+{
+    framerate_ = CLAMP(fps, 1.0, 120.0);
+
+    // keep the current frame at the new framerate
+    size_t index = files_.empty() ? 0 : frame_index();
+
+    GstClockTime step = static_cast<GstClockTime>( static_cast<double>(GST_SECOND) / framerate_ );
+    timeline_.reset();
+    timeline_.setStart(0);
+    timeline_.setStep(step);
+    timeline_.setEnd( MAX(files_.size(), 1) * step );
+
+    position_ = index * step;
+}
+
+double SequenceSource::framerate() const
+{
+    return framerate_;
+}
+
+void SequenceSource::play(bool on)
+{
+    playing_ = on;
+}
+
+bool SequenceSource::isPlaying() const
+{
+    return playing_;
+}
+
+void SequenceSource::setPlaySpeed(double s)
+{
+    speed_ = CLAMP(s, -10.0, 10.0);
+}
+
+double SequenceSource::playSpeed() const
+{
+    return speed_;
+}
+
+void SequenceSource::setLoop(bool on)
+{
+    loop_ = on;
+}
+
+bool SequenceSource::loop() const
+{
+    return loop_;
+}
+
+void SequenceSource::rewind()
+{
+    seek( speed_ < 0.0 ? timeline_.end() - timeline_.step() : 0 );
+}
+
+void SequenceSource::seek(GstClockTime pos)
+{
+    if ( timeline_.duration() == GST_CLOCK_TIME_NONE )
+        return;
+
+    // random access costs the same as playing: frames are independent
+    position_ = MIN(pos, timeline_.end() - timeline_.step());
+    prefetch(frame_index());
+}
+
+GstClockTime SequenceSource::position() const
+{
+    return position_;
+}
+
+size_t SequenceSource::numPrefetched() const
+{
+    std::lock_guard<std::mutex> lock(ring_lock_);
+    return ring_.size();
+}
+
+uint SequenceSource::width() const
+{
+    return width_;
+}
+
+uint SequenceSource::height() const
+{
+    return height_;
+}
+
+bool SequenceSource::failed() const
+{
+    return failed_;
+}
+
+uint SequenceSource::texture() const
+{
+    if (textureindex_ == 0)
+        return Resource::getTextureBlack();
+    return textureindex_;
+}
+
+void SequenceSource::replaceRenderingShader()
+{
+    sequencesurface_->replaceShader(renderingshader_);
+}
+
+size_t SequenceSource::frame_index() const
+{
+    return MIN( position_ / timeline_.step(), files_.size() - 1 );
+}
+
+void SequenceSource::start_workers()
+{
+    stop_ = false;
+
+    // a few threads to decode ahead of the play head
+    uint n = CLAMP( std::thread::hardware_concurrency() / 2, 2, 4);
+    for (uint i = 0; i < n; ++i)
+        workers_.push_back( std::thread(&SequenceSource::decode_frames, this) );
+}
+
+void SequenceSource::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(ring_lock_);
+        stop_ = true;
+        wanted_.clear();
+    }
+    ring_cond_.notify_all();
+
+    for (auto it = workers_.begin(); it != workers_.end(); ++it)
+        it->join();
+    workers_.clear();
+}
+
+void SequenceSource::decode_frames()
+{
+    std::unique_lock<std::mutex> lock(ring_lock_);
+
+    while (!stop_) {
+
+        // first wanted frame not yet decoded nor being decoded
+        auto next = wanted_.end();
+        ring_cond_.wait(lock, [&]{
+            next = std::find_if(wanted_.begin(), wanted_.end(), [&](size_t i){
+                return ring_.count(i) == 0 && pending_.count(i) == 0 && unreadable_.count(i) == 0; });
+            return stop_ || next != wanted_.end();
+        });
+        if (stop_)
+            break;
+
+        size_t index = *next;
+        pending_.insert(index);
+
+        // decode without holding the lock
+        lock.unlock();
+        ImageSource::Image img = ImageSource::loadImage(files_[index]);
+        lock.lock();
+
+        pending_.erase(index);
+
+        // keep the frame only if it is still wanted
+        if ( img.pixels != nullptr ) {
+            if ( std::find(wanted_.begin(), wanted_.end(), index) != wanted_.end() )
+                ring_[index] = img;
+            else
+                stbi_image_free(img.pixels);
+        }
+        // corrupted or unreadable file: skipped when playing
+        else
+            unreadable_.insert(index);
+    }
+}
+
+void SequenceSource::prefetch(size_t index)
+{
+    const size_t n = files_.size();
+    if (n < 1)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(ring_lock_);
+
+        // frames to decode, in the order they will be displayed
+        wanted_.clear();
+        int direction = speed_ < 0.0 ? -1 : 1;
+        for (int i = 0; i < SEQUENCE_RING_SIZE && i < (int) n; ++i) {
+            long long f = static_cast<long long>(index) + direction * i;
+            if ( f < 0 || f >= (long long) n ) {
+                if (!loop_)
+                    break;
+                f = (f + n) % n;
+            }
+            wanted_.push_back( static_cast<size_t>(f) );
+        }
+
+        // free frames which are not wanted anymore
+        for (auto it = ring_.begin(); it != ring_.end(); ) {
+            if ( it->first != displayed_ &&
+                 std::find(wanted_.begin(), wanted_.end(), it->first) == wanted_.end() ) {
+                stbi_image_free(it->second.pixels);
+                it = ring_.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    ring_cond_.notify_all();
+}
+
+void SequenceSource::update(float dt)
+{
+    Source::update(dt);
+
+    if ( files_.empty() || timeline_.duration() == GST_CLOCK_TIME_NONE )
+        return;
+
+    // advance play head (dt is in milisecond)
+    // (not before the first frame is displayed: it must stay wanted)
+    if ( initialized_ && active_ && playing_ ) {
+        const gint64 end  = static_cast<gint64>( timeline_.end() );
+        const gint64 last = end - static_cast<gint64>( timeline_.step() );
+        gint64 pos = static_cast<gint64>(position_) + static_cast<gint64>( dt * 1000000.0 * speed_ );
+        if ( pos > last || pos < 0 ) {
+            if (loop_)
+                pos = ( (pos % end) + end ) % end;
+            else {
+                pos = CLAMP(pos, 0, last);
+                playing_ = false;
+            }
+        }
+        position_ = static_cast<GstClockTime>(pos);
+    }
+
+    prefetch( frame_index() );
+}
+
+void SequenceSource::init()
+{
+    if ( files_.empty() )
+        return;
+
+    // wait for the frame at the play head to be decoded (e.g. after a seek)
+    ImageSource::Image img;
+    size_t index = frame_index();
+    {
+        std::lock_guard<std::mutex> lock(ring_lock_);
+        // the first frame cannot be decoded
+        if ( unreadable_.count(index) > 0 ) {
+            failed_ = true;
+            return;
+        }
+        auto it = ring_.find(index);
+        if ( it == ring_.end() )
+            return;
+        img = it->second;
+    }
+    displayed_ = index;
+    width_ = img.width;
+    height_ = img.height;
+
+    // texture with the size of the first image
+    glGenTextures(1, &textureindex_);
+    glBindTexture(GL_TEXTURE_2D, textureindex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width_, height_);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, img.pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // apply the texture to the surface
+    sequencesurface_->setTextureIndex( textureindex_ );
+
+    // create Frame buffer matching size of images
+    FrameBuffer *renderbuffer = new FrameBuffer(width_, height_, true);
+
+    // set the renderbuffer of the source and attach rendering nodes
+    attach(renderbuffer);
+
+    // icon in mixing view
+    overlays_[View::MIXING]->attach( new Symbol(Symbol::VIDEO, glm::vec3(0.8f, 0.8f, 0.01f)) );
+    overlays_[View::LAYER]->attach( new Symbol(Symbol::VIDEO, glm::vec3(0.8f, 0.8f, 0.01f)) );
+
+    // done init
+    initialized_ = true;
+    Log::Info("Source Sequence linked to %s.", path_.c_str());
+
+    // force update of activation mode
+    active_ = true;
+    touch();
+}
+
+void SequenceSource::render()
+{
+    if (!initialized_)
+        init();
+    else {
+        // upload the frame at play head if it is decoded (otherwise keep the previous)
+        size_t index = frame_index();
+        if ( index != displayed_ ) {
+            ImageSource::Image img;
+            {
+                // frames are only freed by this thread in prefetch()
+                std::lock_guard<std::mutex> lock(ring_lock_);
+                auto it = ring_.find(index);
+                if ( it != ring_.end() )
+                    img = it->second;
+            }
+            if ( img.pixels != nullptr ) {
+                if ( img.width == (int) width_ && img.height == (int) height_ ) {
+                    glBindTexture(GL_TEXTURE_2D, textureindex_);
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, img.pixels);
+                    glBindTexture(GL_TEXTURE_2D, 0);
+                }
+                displayed_ = index;
+            }
+        }
+
+        // render the image into frame buffer
+        static glm::mat4 projection = glm::ortho(-1.f, 1.f, 1.f, -1.f, -1.f, 1.f);
+        renderbuffer_->begin();
+        sequencesurface_->draw(glm::identity<glm::mat4>(), projection);
+        renderbuffer_->end();
+    }
+}
+
+void SequenceSource::accept(Visitor& v)
+{
+    Source::accept(v);
+    v.visit(*this);
+}
@@ -0,0 +1,98 @@
+#ifndef SEQUENCESOURCE_H
+#define SEQUENCESOURCE_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+
+#include "Source.h"
+#include "ImageSource.h"
+#include "Timeline.h"
+
+#define SEQUENCE_DEFAULT_FPS 25.0
+#define SEQUENCE_RING_SIZE 16
+
+class SequenceSource : public Source
+{
+public:
+    SequenceSource();
+    ~SequenceSource();
+
+    // implementation of source API
+    void update (float dt) override;
+    void render() override;
+    bool failed() const override;
+    uint texture() const override;
+    void accept (Visitor& v) override;
+
+    // Sequence specific interface
+    // open a folder containing numbered image files
+    void setPath(const std::string &folder);
+    std::string path() const;
+    size_t numFrames() const;
+
+    void setFramerate(double fps);
+    double framerate() const;
+
+    // playback (speed is negative for reverse)
+    void play(bool on);
+    bool isPlaying() const;
+    void setPlaySpeed(double s);
+    double playSpeed() const;
+    void setLoop(bool on);
+    bool loop() const;
+    void rewind();
+    void seek(GstClockTime pos);
+    GstClockTime position() const;
+    inline Timeline *timeline() { return &timeline_; }
+
+    // statistics of the prefetch ring
+    size_t numPrefetched() const;
+    uint width() const;
+    uint height() const;
+
+protected:
+
+    void init() override;
+    void replaceRenderingShader() override;
+
+    // prefetching of frames by a pool of decoding threads
+    void start_workers();
+    void stop_workers();
+    void decode_frames();
+    void prefetch(size_t index);
+    size_t frame_index() const;
+
+    Surface *sequencesurface_;
+    std::string path_;
+    std::vector<std::string> files_;
+    uint textureindex_;
+    uint width_, height_;
+    std::atomic<bool> failed_;
+
+    // timing
+    Timeline timeline_;
+    GstClockTime position_;
+    double framerate_;
+    double speed_;
+    bool playing_;
+    bool loop_;
+    size_t displayed_;
+
+    // ring of decoded frames, ready for upload
+    mutable std::mutex ring_lock_;
+    std::condition_variable ring_cond_;
+    std::map<size_t, ImageSource::Image> ring_;
+    std::set<size_t> pending_;
+    std::set<size_t> unreadable_; // could not be decoded (never tried again)
+    std::deque<size_t> wanted_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+};
+
+#endif // SEQUENCESOURCE_H
@@ -7,6 +7,8 @@
 #include "Mesh.h"
 #include "Source.h"
 #include "MediaSource.h"
+#include "ImageSource.h"
+#include "SequenceSource.h"
 #include "SessionSource.h"
 #include "Session.h"
 #include "ImageShader.h"
@@ -96,9 +98,28 @@ void SessionCreator::loadSession(XMLElement *sessionNode)
             if (!pType)
                 continue;
             if ( std::string(pType) == "MediaSource") {
-                MediaSource *new_media_source = new MediaSource();
-                new_media_source->accept(*this);
-                session_->addSource(new_media_source);
+                // still images of sessions saved before ImageSource existed
+                XMLElement* uriNode = xmlCurrent_->FirstChildElement("uri");
+                if ( uriNode && uriNode->GetText() && ImageSource::supported(uriNode->GetText()) ) {
+                    ImageSource *new_image_source = new ImageSource();
+                    new_image_source->accept(*this);
+                    session_->addSource(new_image_source);
+                }
+                else {
+                    MediaSource *new_media_source = new MediaSource();
+                    new_media_source->accept(*this);
+                    session_->addSource(new_media_source);
+                }
+            }
+            else if ( std::string(pType) == "ImageSource") {
+                ImageSource *new_image_source = new ImageSource();
+                new_image_source->accept(*this);
+                session_->addSource(new_image_source);
+            }
+            else if ( std::string(pType) == "SequenceSource") {
+                SequenceSource *new_sequence_source = new SequenceSource();
+                new_sequence_source->accept(*this);
+                session_->addSource(new_sequence_source);
             }
             else if ( std::string(pType) == "SessionSource") {
                 SessionSource *new_session_source = new SessionSource();
@@ -203,6 +224,12 @@ void SessionCreator::visit(MediaPlayer &n)
         int loop = 1;
         mediaplayerNode->QueryIntAttribute("loop", &loop);
         n.setLoop( (MediaPlayer::LoopMode) loop);
+        bool clip = false;
+        mediaplayerNode->QueryBoolAttribute("clip_cache", &clip);
+        n.setClipCache(clip);
+        int deinterlace = VideoShader::DEINTERLACE_ADAPTIVE;
+        mediaplayerNode->QueryIntAttribute("deinterlace", &deinterlace);
+        n.setDeinterlace( (VideoShader::Deinterlace) deinterlace);
         bool play = true;
         mediaplayerNode->QueryBoolAttribute("play", &play);
         n.play(play);
@@ -307,6 +334,39 @@ void SessionCreator::visit (MediaSource& s)
     s.mediaplayer()->accept(*this);
 }
 
+void SessionCreator::visit (ImageSource& s)
+{
+    // set uri
+    XMLElement* uriNode = xmlCurrent_->FirstChildElement("uri");
+    if (uriNode && uriNode->GetText()) {
+        std::string uri = std::string ( uriNode->GetText() );
+        s.setPath(uri);
+    }
+}
+
+void SessionCreator::visit (SequenceSource& s)
+{
+    double fps = SEQUENCE_DEFAULT_FPS;
+    xmlCurrent_->QueryDoubleAttribute("framerate", &fps);
+    s.setFramerate(fps);
+    double speed = 1.0;
+    xmlCurrent_->QueryDoubleAttribute("speed", &speed);
+    s.setPlaySpeed(speed);
+    bool loop = true;
+    xmlCurrent_->QueryBoolAttribute("loop", &loop);
+    s.setLoop(loop);
+    bool play = true;
+    xmlCurrent_->QueryBoolAttribute("play", &play);
+    s.play(play);
+
+    // set folder
+    XMLElement* pathNode = xmlCurrent_->FirstChildElement("path");
+    if (pathNode && pathNode->GetText()) {
+        std::string path = std::string ( pathNode->GetText() );
+        s.setPath(path);
+    }
+}
+
 void SessionCreator::visit (SessionSource& s)
 {
     // set uri
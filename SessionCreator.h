@@ -47,6 +47,8 @@ public:
 
     void visit (Source& s) override;
     void visit (MediaSource& s) override;
+    void visit (ImageSource& s) override;
+    void visit (SequenceSource& s) override;
     void visit (SessionSource& s) override;
 
     static std::string info(const std::string& filename);
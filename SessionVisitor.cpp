@@ -6,6 +6,8 @@
 #include "Mesh.h"
 #include "Source.h"
 #include "MediaSource.h"
+#include "ImageSource.h"
+#include "SequenceSource.h"
 #include "SessionSource.h"
 #include "ImageShader.h"
 #include "ImageProcessingShader.h"
@@ -146,6 +148,8 @@ void SessionVisitor::visit(MediaPlayer &n)
     newelement->SetAttribute("play", n.isPlaying());
     newelement->SetAttribute("loop", (int) n.loop());
     newelement->SetAttribute("speed", n.playSpeed());
+    newelement->SetAttribute("clip_cache", n.clipCache());
+    newelement->SetAttribute("deinterlace", (int) n.deinterlace());
 
     // gaps in timeline
     XMLElement *gapselement = xmlDoc_->NewElement("Gaps");
@@ -345,6 +349,30 @@ void SessionVisitor::visit (MediaSource& s)
     s.mediaplayer()->accept(*this);
 }
 
+void SessionVisitor::visit (ImageSource& s)
+{
+    xmlCurrent_->SetAttribute("type", "ImageSource");
+
+    XMLElement *uri = xmlDoc_->NewElement("uri");
+    xmlCurrent_->InsertEndChild(uri);
+    XMLText *text = xmlDoc_->NewText( s.path().c_str() );
+    uri->InsertEndChild( text );
+}
+
+void SessionVisitor::visit (SequenceSource& s)
+{
+    xmlCurrent_->SetAttribute("type", "SequenceSource");
+    xmlCurrent_->SetAttribute("framerate", s.framerate());
+    xmlCurrent_->SetAttribute("speed", s.playSpeed());
+    xmlCurrent_->SetAttribute("loop", s.loop());
+    xmlCurrent_->SetAttribute("play", s.isPlaying());
+
+    XMLElement *path = xmlDoc_->NewElement("path");
+    xmlCurrent_->InsertEndChild(path);
+    XMLText *text = xmlDoc_->NewText( s.path().c_str() );
+    path->InsertEndChild( text );
+}
+
 void SessionVisitor::visit (SessionSource& s)
 {
     xmlCurrent_->SetAttribute("type", "SessionSource");
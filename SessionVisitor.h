@@ -41,6 +41,8 @@ public:
 
     void visit (Source& s) override;
     void visit (MediaSource& s) override;
+    void visit (ImageSource& s) override;
+    void visit (SequenceSource& s) override;
     void visit (SessionSource& s) override;
     void visit (RenderSource& s) override;
     void visit (CloneSource& s) override;
@@ -75,6 +75,7 @@ void Settings::Save()
     RenderNode->SetAttribute("vsync", application.render.vsync);
     RenderNode->SetAttribute("multisampling", application.render.multisampling);
     RenderNode->SetAttribute("blit", application.render.blit);
+    RenderNode->SetAttribute("gpu_colorspace", application.render.gpu_colorspace);
     RenderNode->SetAttribute("ratio", application.render.ratio);
     RenderNode->SetAttribute("res", application.render.res);
     pRoot->InsertEndChild(RenderNode);
@@ -84,8 +85,39 @@ void Settings::Save()
     RecordNode->SetAttribute("path", application.record.path.c_str());
     RecordNode->SetAttribute("profile", application.record.profile);
     RecordNode->SetAttribute("timeout", application.record.timeout);
+    RecordNode->SetAttribute("readback_depth", application.record.readback_depth);
+    RecordNode->SetAttribute("framerate", application.record.framerate);
+    RecordNode->SetAttribute("queue_size", application.record.queue_size);
+    RecordNode->SetAttribute("queue_policy", application.record.queue_policy);
     pRoot->InsertEndChild(RecordNode);
 
+    // Media
+    XMLElement *MediaNode = xmlDoc.NewElement( "Media" );
+    MediaNode->SetAttribute("queue_depth", application.media.queue_depth);
+    MediaNode->SetAttribute("cache_budget", application.media.cache_budget);
+    MediaNode->SetAttribute("clip_cache_budget", application.media.clip_cache_budget);
+    MediaNode->SetAttribute("decoder_threads", application.media.decoder_threads);
+    MediaNode->SetAttribute("adaptive_resolution", application.media.adaptive_resolution);
+    MediaNode->SetAttribute("proxy", application.media.proxy);
+    MediaNode->SetAttribute("proxy_profile", application.media.proxy_profile);
+    MediaNode->SetAttribute("proxy_height", application.media.proxy_height);
+    MediaNode->SetAttribute("proxy_path", application.media.proxy_path.c_str());
+    MediaNode->SetAttribute("ram_budget", application.media.ram_budget);
+    MediaNode->SetAttribute("vram_budget", application.media.vram_budget);
+    MediaNode->SetAttribute("hibernate_delay", application.media.hibernate_delay);
+    MediaNode->SetAttribute("info_cache_budget", application.media.info_cache_budget);
+    for (auto it = application.media.decoders.begin(); it != application.media.decoders.end(); ++it) {
+        XMLElement *codecNode = xmlDoc.NewElement( "Codec" );
+        codecNode->SetAttribute("caps", it->first.c_str());
+        for (auto d = it->second.begin(); d != it->second.end(); ++d) {
+            XMLElement *decoderNode = xmlDoc.NewElement( "Decoder" );
+            decoderNode->SetAttribute("name", d->c_str());
+            codecNode->InsertEndChild(decoderNode);
+        }
+        MediaNode->InsertEndChild(codecNode);
+    }
+    pRoot->InsertEndChild(MediaNode);
+
     // Transition
     XMLElement *TransitionNode = xmlDoc.NewElement( "Transition" );
     TransitionNode->SetAttribute("auto_open", application.transition.auto_open);
@@ -222,6 +254,7 @@ void Settings::Load()
         rendernode->QueryIntAttribute("vsync", &application.render.vsync);
         rendernode->QueryIntAttribute("multisampling", &application.render.multisampling);
         rendernode->QueryBoolAttribute("blit", &application.render.blit);
+        rendernode->QueryBoolAttribute("gpu_colorspace", &application.render.gpu_colorspace);
         rendernode->QueryIntAttribute("ratio", &application.render.ratio);
         rendernode->QueryIntAttribute("res", &application.render.res);
     }
@@ -231,6 +264,10 @@ void Settings::Load()
     if (recordnode != nullptr) {
         recordnode->QueryIntAttribute("profile", &application.record.profile);
         recordnode->QueryFloatAttribute("timeout", &application.record.timeout);
+        recordnode->QueryIntAttribute("readback_depth", &application.record.readback_depth);
+        recordnode->QueryIntAttribute("framerate", &application.record.framerate);
+        recordnode->QueryIntAttribute("queue_size", &application.record.queue_size);
+        recordnode->QueryIntAttribute("queue_policy", &application.record.queue_policy);
 
         const char *path_ = recordnode->Attribute("path");
         if (path_)
@@ -239,6 +276,42 @@ void Settings::Load()
             application.record.path = SystemToolkit::home_path();
     }
 
+    // Media
+    XMLElement * medianode = pRoot->FirstChildElement("Media");
+    if (medianode != nullptr) {
+        medianode->QueryIntAttribute("queue_depth", &application.media.queue_depth);
+        medianode->QueryIntAttribute("cache_budget", &application.media.cache_budget);
+        medianode->QueryIntAttribute("clip_cache_budget", &application.media.clip_cache_budget);
+        medianode->QueryIntAttribute("decoder_threads", &application.media.decoder_threads);
+        medianode->QueryBoolAttribute("adaptive_resolution", &application.media.adaptive_resolution);
+        medianode->QueryBoolAttribute("proxy", &application.media.proxy);
+        medianode->QueryIntAttribute("proxy_profile", &application.media.proxy_profile);
+        medianode->QueryIntAttribute("proxy_height", &application.media.proxy_height);
+        medianode->QueryIntAttribute("ram_budget", &application.media.ram_budget);
+        medianode->QueryIntAttribute("vram_budget", &application.media.vram_budget);
+        medianode->QueryIntAttribute("hibernate_delay", &application.media.hibernate_delay);
+        medianode->QueryIntAttribute("info_cache_budget", &application.media.info_cache_budget);
+        const char *proxy_path_ = medianode->Attribute("proxy_path");
+        if (proxy_path_)
+            application.media.proxy_path = std::string(proxy_path_);
+        application.media.decoders.clear();
+        XMLElement* codecNode = medianode->FirstChildElement("Codec");
+        for( ; codecNode ; codecNode=codecNode->NextSiblingElement("Codec"))
+        {
+            const char *caps_ = codecNode->Attribute("caps");
+            if (!caps_)
+                continue;
+            std::list<std::string> &ranking = application.media.decoders[std::string(caps_)];
+            XMLElement* decoderNode = codecNode->FirstChildElement("Decoder");
+            for( ; decoderNode ; decoderNode=decoderNode->NextSiblingElement("Decoder"))
+            {
+                const char *name_ = decoderNode->Attribute("name");
+                if (name_)
+                    ranking.push_back( std::string(name_) );
+            }
+        }
+    }
+
     // Transition
     XMLElement * transitionnode = pRoot->FirstChildElement("Transition");
     if (transitionnode != nullptr) {
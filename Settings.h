@@ -59,16 +59,26 @@ struct ViewConfig
 };
 
 #define RECORD_MAX_TIMEOUT 1800.f
+#define RECORD_MAX_READBACK 8
+#define RECORD_MAX_QUEUE 16
 
 struct RecordConfig
 {
     std::string path;
     int profile;
     float timeout;
+    int readback_depth; // frames in asynchronous transfer from GPU
+    int framerate;      // VideoRecorder::framerate_preset
+    int queue_size;     // frames waiting for the encoder
+    int queue_policy;   // VideoRecorder::QueuePolicy when queue is full
 
     RecordConfig() : path("") {
         profile = 0;
         timeout = RECORD_MAX_TIMEOUT;
+        readback_depth = 3;
+        framerate = 3; // 30 fps
+        queue_size = 8;
+        queue_policy = 2; // drop newest
     }
 
 };
@@ -117,9 +127,45 @@ struct TransitionConfig
     }
 };
 
+struct MediaConfig
+{
+    int queue_depth;
+    int cache_budget; // MB, shared by all media players, 0 to disable
+    int clip_cache_budget; // MB, shared by all media players
+    int decoder_threads; // shared by all media players, 0 for all cores
+    bool adaptive_resolution;
+    bool proxy;
+    int proxy_profile; // VideoRecorder::Profile
+    int proxy_height;  // 0 to keep resolution
+    std::string proxy_path;
+    int ram_budget;      // MB, for all media players (not their caches), 0 for unlimited
+    int vram_budget;     // MB, for all media players, 0 for unlimited
+    int hibernate_delay; // s, before releasing resources of inactive media
+    int info_cache_budget; // MB, for files of information and index of media in cache
+    // decoders of each codec, from best to worst (benchmarked)
+    std::map<std::string, std::list<std::string> > decoders;
+
+    MediaConfig() {
+        queue_depth = 3;
+        cache_budget = 256;
+        clip_cache_budget = 512;
+        decoder_threads = 0;
+        adaptive_resolution = true;
+        proxy = false;
+        proxy_profile = 7; // Multiple JPEG (intra-only)
+        proxy_height = 720;
+        proxy_path = "";
+        ram_budget = 4096;
+        vram_budget = 1024;
+        hibernate_delay = 30;
+        info_cache_budget = 64;
+    }
+};
+
 struct RenderConfig
 {
     bool blit;
+    bool gpu_colorspace;
     int vsync;
     int multisampling;
     int ratio;
@@ -128,6 +174,7 @@ struct RenderConfig
 
     RenderConfig() {
         blit = false;
+        gpu_colorspace = true;
         vsync = 1; // todo GUI selection
         multisampling = 2; // todo GUI selection
         ratio = 3;
@@ -161,6 +208,9 @@ struct Application
     // settings render
     RecordConfig record;
 
+    // settings media players
+    MediaConfig media;
+
     // settings transition
     TransitionConfig transition;
 
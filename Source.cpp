@@ -17,7 +17,7 @@
 #include "Log.h"
 #include "Mixer.h"
 
-Source::Source() : initialized_(false), active_(true), need_update_(true)
+Source::Source() : initialized_(false), active_(true), need_update_(true), preroll_(0.f)
 {
     sprintf(initials_, "__");
     name_ = "Source";
@@ -301,6 +301,26 @@ void Source::setActive (bool on)
     groups_[View::LAYER]->visible_ = active_;
 
 }
+
+void Source::predict (glm::vec2 mixing)
+{
+    if ( glm::length(mixing) < MIXING_ACTIVE_DISTANCE )
+        anticipate();
+}
+
+void Source::anticipate ()
+{
+    if (active_)
+        return;
+
+    // start pre-roll
+    if ( preroll_ <= 0.f )
+        preroll(true);
+
+    // (re)start timeout
+    preroll_ = MIXING_PREROLL_TIMEOUT;
+}
+
 // Transfer functions from coordinates to alpha (1 - transparency)
 float linear_(float x, float y) {
     return 1.f - CLAMP( sqrt( ( x * x ) + ( y * y ) ), 0.f, 1.f );
@@ -319,6 +339,16 @@ void Source::update(float dt)
     // keep delta-t
     dt_ = dt;
 
+    // pre-roll ends when activated, or when not predicted anymore
+    if ( preroll_ > 0.f ) {
+        preroll_ = active_ ? 0.f : preroll_ - dt;
+        if ( preroll_ <= 0.f ) {
+            preroll_ = 0.f;
+            if (!active_)
+                preroll(false);
+        }
+    }
+
     // update nodes if needed
     if (need_update_)
     {
@@ -329,7 +359,7 @@ void Source::update(float dt)
         blendingshader_->color.a = sin_quad( dist.x, dist.y );
 
         // CHANGE update status based on limbo
-        setActive( glm::length(dist) < 1.3f );
+        setActive( glm::length(dist) < MIXING_ACTIVE_DISTANCE );
 
         // MODIFY geometry based on GEOMETRY node
         groups_[View::RENDERING]->translation_ = groups_[View::GEOMETRY]->translation_;
@@ -469,6 +499,15 @@ void CloneSource::setActive (bool on)
 }
 
 
+void CloneSource::predict (glm::vec2 mixing)
+{
+    Source::predict(mixing);
+
+    // the origin produces the frames of the clone
+    if ( origin_ != nullptr && glm::length(mixing) < MIXING_ACTIVE_DISTANCE )
+        origin_->anticipate();
+}
+
 uint CloneSource::texture() const
 {
     if (initialized_ && origin_ != nullptr)
@@ -482,6 +521,9 @@ void CloneSource::render()
     if (!initialized_)
         init();
     else if (origin_) {
+        // the texture of the origin changes (e.g. frames in OpenGL memory, resized or re-opened)
+        clonesurface_->setTextureIndex( origin_->texture() );
+
         // render the view into frame buffer
         static glm::mat4 projection = glm::ortho(-1.f, 1.f, 1.f, -1.f, -1.f, 1.f);
         renderbuffer_->begin();
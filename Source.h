@@ -93,6 +93,11 @@ public:
     virtual void setActive (bool on);
     inline bool active () { return active_; }
 
+    // anticipate activation, given the position predicted in mixing view
+    // (an inactive source expected in the active area is pre-rolled)
+    virtual void predict (glm::vec2 mixing);
+    inline bool prerolling () const { return preroll_ > 0.f; }
+
     // a Source shall informs if the source failed (i.e. shall be deleted)
     virtual bool failed() const = 0;
 
@@ -170,6 +175,12 @@ protected:
     float dt_;
     Group *stored_status_;
 
+    // pre-roll before activation (remaining time in ms)
+    // sub-classes prepare to be activated in preroll()
+    float preroll_;
+    void anticipate ();
+    virtual void preroll (bool) {}
+
     // clones
     CloneList clones_;
 };
@@ -185,6 +196,7 @@ public:
 
     // implementation of source API
     void setActive (bool on) override;
+    void predict (glm::vec2 mixing) override;
     void render() override;
     uint texture() const override;
     bool failed() const override  { return origin_ == nullptr; }
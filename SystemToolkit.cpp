@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <ctime>
 #include <chrono>
+#include <functional>
 
 using namespace std;
 
@@ -88,6 +89,14 @@ long SystemToolkit::memory_max_usage() {
 //    return r_usage.ru_isrss;
 }
 
+double SystemToolkit::cpu_time() {
+
+    struct rusage r_usage;
+    getrusage(RUSAGE_SELF,&r_usage);
+    return static_cast<double>(r_usage.ru_utime.tv_sec + r_usage.ru_stime.tv_sec)
+            + static_cast<double>(r_usage.ru_utime.tv_usec + r_usage.ru_stime.tv_usec) * 0.000001;
+}
+
 string SystemToolkit::byte_to_string(long b)
 {
     double numbytes = static_cast<double>(b);
@@ -243,6 +252,21 @@ string SystemToolkit::settings_path()
     }
 }
 
+string SystemToolkit::cache_path()
+{
+    // cache in 'cache' subfolder of settings
+    string cachepath = full_filename(settings_path(), "cache");
+
+    // create the cache subfolder if not existing already
+    if ( !SystemToolkit::file_exists(cachepath) ) {
+        if ( !create_directory(cachepath) )
+            // fallback to settings path if cache path cannot be created
+            cachepath = settings_path();
+    }
+
+    return cachepath;
+}
+
 string SystemToolkit::full_filename(const std::string& path, const string &filename)
 {
     string fullfilename = path;
@@ -263,6 +287,41 @@ bool SystemToolkit::file_exists(const string& path)
 }
 
 
+string SystemToolkit::file_signature(const string& path)
+{
+    struct stat sb;
+    if ( path.empty() || stat(path.c_str(), &sb) != 0 )
+        return string();
+
+    // hash of the full path, with size and time of last modification
+    std::ostringstream key;
+    key << path << '|' << sb.st_size << '|' << sb.st_mtime;
+
+    std::ostringstream signature;
+    signature << std::hex << std::setfill('0') << std::setw(16) << std::hash<string>{}(key.str());
+    signature << std::setw(8) << static_cast<unsigned long>(sb.st_size & 0xFFFFFFFF);
+
+    return signature.str();
+}
+
+long SystemToolkit::file_size(const string& path)
+{
+    struct stat sb;
+    if ( path.empty() || stat(path.c_str(), &sb) != 0 )
+        return 0;
+
+    return static_cast<long>(sb.st_size);
+}
+
+long SystemToolkit::file_time(const string& path)
+{
+    struct stat sb;
+    if ( path.empty() || stat(path.c_str(), &sb) != 0 )
+        return 0;
+
+    return static_cast<long>(sb.st_mtime);
+}
+
 // tests if dir is a directory and return its path, empty string otherwise
 std::string SystemToolkit::path_directory(const std::string& path)
 {
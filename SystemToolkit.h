@@ -27,6 +27,9 @@ namespace SystemToolkit
     // get the OS dependent path where to store settings
     std::string settings_path();
 
+    // get the OS dependent path where to store cached files (in settings path)
+    std::string cache_path();
+
     // builds the OS dependent complete file name
     std::string full_filename(const std::string& path, const std::string& filename);
 
@@ -54,6 +57,15 @@ namespace SystemToolkit
     // true of file exists
     bool file_exists(const std::string& path);
 
+    // get a string identifying the file and its version (from path, size and modification time)
+    // empty string if the file does not exist
+    std::string file_signature(const std::string& path);
+
+    // get size of a file (in bytes) and time of its last modification (in seconds)
+    // 0 if the file does not exist
+    long file_size(const std::string& path);
+    long file_time(const std::string& path);
+
     bool create_directory(const std::string& path);
 
 
@@ -64,6 +76,9 @@ namespace SystemToolkit
     long memory_usage();
     long memory_max_usage();
 
+    // return processor time used by the process (user and system, in seconds)
+    double cpu_time();
+
     // get a string to display memory size with unit KB, MB, GB, TB
     std::string byte_to_string(long b);
 }
@@ -27,6 +27,10 @@ void Timeline::reset()
     timing_.end = GST_CLOCK_TIME_NONE;
     step_ = GST_CLOCK_TIME_NONE;
 
+    // forget index
+    index_.reset();
+    keyframes_.reset();
+
 //    // clear gaps
 //    gaps_.clear();
 
@@ -122,6 +126,75 @@ void Timeline::updateArrayFromGaps()
 //    }
 }
 
+void Timeline::setIndex(const FrameIndex &index)
+{
+    std::vector<GstClockTime> *keyframes = new std::vector<GstClockTime>;
+    for (auto it = index.begin(); it != index.end(); ++it) {
+        if ( it->keyframe )
+            keyframes->push_back( it->pts );
+    }
+
+    index_ = std::make_shared<const FrameIndex>(index);
+    keyframes_ = std::shared_ptr<const std::vector<GstClockTime> >(keyframes);
+}
+
+bool Timeline::isIndexed() const
+{
+    return index_ != nullptr && !index_->empty();
+}
+
+size_t Timeline::numKeyframes() const
+{
+    return keyframes_ ? keyframes_->size() : 0;
+}
+
+const std::vector<GstClockTime> &Timeline::keyframes() const
+{
+    static std::vector<GstClockTime> empty;
+    return keyframes_ ? *keyframes_ : empty;
+}
+
+GstClockTime Timeline::keyframeBefore(const GstClockTime t) const
+{
+    if ( numKeyframes() < 1 )
+        return GST_CLOCK_TIME_NONE;
+
+    // first key frame after t, and go back one
+    auto k = std::upper_bound(keyframes_->begin(), keyframes_->end(), t);
+    if ( k == keyframes_->begin() )
+        return GST_CLOCK_TIME_NONE;
+
+    return *(--k);
+}
+
+GstClockTime Timeline::nextFrame(const GstClockTime t) const
+{
+    if ( !isIndexed() )
+        return GST_CLOCK_TIME_NONE;
+
+    FrameIndexEntry e;
+    e.pts = t;
+    auto f = std::upper_bound(index_->begin(), index_->end(), e);
+    if ( f == index_->end() )
+        return GST_CLOCK_TIME_NONE;
+
+    return f->pts;
+}
+
+GstClockTime Timeline::previousFrame(const GstClockTime t) const
+{
+    if ( !isIndexed() )
+        return GST_CLOCK_TIME_NONE;
+
+    FrameIndexEntry e;
+    e.pts = t;
+    auto f = std::lower_bound(index_->begin(), index_->end(), e);
+    if ( f == index_->begin() )
+        return GST_CLOCK_TIME_NONE;
+
+    return (--f)->pts;
+}
+
 size_t Timeline::numGaps()
 {
     return gaps_.size();
@@ -5,6 +5,8 @@
 #include <sstream>
 #include <set>
 #include <list>
+#include <vector>
+#include <memory>
 
 #include <gst/pbutils/pbutils.h>
 
@@ -80,6 +82,23 @@ private:
 typedef std::set<TimeInterval> TimeIntervalSet;
 
 
+struct FrameIndexEntry
+{
+    GstClockTime pts;
+    guint64 offset;   // byte offset in the file (GST_BUFFER_OFFSET_NONE if unknown)
+    bool keyframe;
+
+    FrameIndexEntry() : pts(GST_CLOCK_TIME_NONE), offset(GST_BUFFER_OFFSET_NONE), keyframe(false) { }
+    inline bool operator < (const FrameIndexEntry& b) const
+    {
+        return this->pts < b.pts;
+    }
+};
+
+// table of all frames of a media, sorted by presentation time
+typedef std::vector<FrameIndexEntry> FrameIndex;
+
+
 class Timeline
 {
 public:
@@ -112,6 +131,17 @@ public:
     bool gapAt(const GstClockTime t, TimeInterval &gap);
     std::list< std::pair<guint64, guint64> > gaps() const;
 
+    // index of frames (shared by copies of the timeline)
+    void setIndex(const FrameIndex &index);
+    bool isIndexed() const;
+    size_t numKeyframes() const;
+    const std::vector<GstClockTime> &keyframes() const;
+    // presentation time of the key frame at or before t
+    GstClockTime keyframeBefore(const GstClockTime t) const;
+    // presentation time of the frames after and before the frame at t
+    GstClockTime nextFrame(const GstClockTime t) const;
+    GstClockTime previousFrame(const GstClockTime t) const;
+
     // direct access to the array representation of the timeline
     // TODO : implement an ImGui widget to plot a timeline instead of an array
     float *array();
@@ -129,6 +159,10 @@ private:
     // main data structure containing list of gaps in the timeline
     TimeIntervalSet gaps_;
 
+    // index of frames and list of key frames (read only once set)
+    std::shared_ptr<const FrameIndex> index_;
+    std::shared_ptr<const std::vector<GstClockTime> > keyframes_;
+
     // supplementary data structure needed to display and edit the timeline
     bool need_update_;
     void init_array();
@@ -128,6 +128,8 @@ static std::string ImportFileDialog(const std::string &path)
 
 static std::vector< std::future<std::string> > recentFolderFileDialogs;
 static std::vector< std::future<std::string> > recordFolderFileDialogs;
+static std::vector< std::future<std::string> > sequenceFolderDialogs;
+static std::vector< std::future<std::string> > proxyFolderDialogs;
 static std::string FolderDialog(const std::string &path)
 {
     std::string foldername = "";
@@ -976,6 +978,8 @@ void UserInterface::RenderPreview()
                     // select profile
                     ImGui::SetNextItemWidth(300);
                     ImGui::Combo("##RecProfile", &Settings::application.record.profile, VideoRecorder::profile_name, IM_ARRAYSIZE(VideoRecorder::profile_name) );
+                    ImGui::SetNextItemWidth(300);
+                    ImGui::Combo("##RecFramerate", &Settings::application.record.framerate, VideoRecorder::framerate_name, IM_ARRAYSIZE(VideoRecorder::framerate_name) );
                 }
 
                 // Options menu
@@ -1011,6 +1015,14 @@ void UserInterface::RenderPreview()
                     ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
                     ImGui::SliderFloat("Timeout", &Settings::application.record.timeout, 1.f, RECORD_MAX_TIMEOUT,
                                        Settings::application.record.timeout < (RECORD_MAX_TIMEOUT - 1.f) ? "%.0f s" : "None", 3.f);
+
+                    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+                    ImGui::SliderInt("Buffering", &Settings::application.record.readback_depth, 2, RECORD_MAX_READBACK, "%d frames");
+
+                    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+                    ImGui::SliderInt("Queue", &Settings::application.record.queue_size, 1, RECORD_MAX_QUEUE, "%d frames");
+                    ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+                    ImGui::Combo("When full", &Settings::application.record.queue_policy, VideoRecorder::queue_policy_name, IM_ARRAYSIZE(VideoRecorder::queue_policy_name) );
                 }
 
                 ImGui::EndMenu();
@@ -1036,6 +1048,20 @@ void UserInterface::RenderPreview()
             ImGui::Text(ICON_FA_CIRCLE " %s", rec->info().c_str() );
             ImGui::PopStyleColor(1);
             ImGui::PopFont();
+            // encoder load
+            VideoRecorder *vrec = dynamic_cast<VideoRecorder *>(rec);
+            if (vrec) {
+                ImGui::SetCursorScreenPos(ImVec2(draw_pos.x + r, ImGui::GetCursorScreenPos().y));
+                ImGui::PushStyleColor(ImGuiCol_Text, vrec->queueDropped() + vrec->queueBlocked() > 0 ?
+                                          ImVec4(1.0, 0.05, 0.05, 0.8f) : ImVec4(1.0, 1.0, 1.0, 0.8f));
+                ImGui::Text("Encoder %.1f fps, queue %d/%d, %lu dropped", vrec->encoderFramerate(),
+                            vrec->queueDepth(), vrec->queueSize(), (unsigned long) vrec->queueDropped());
+                if (vrec->queueBlocked() > 0) {
+                    ImGui::SameLine(0, 0);
+                    ImGui::Text(", %lu waits", (unsigned long) vrec->queueBlocked());
+                }
+                ImGui::PopStyleColor(1);
+            }
         }
         // tooltip overlay
         if (ImGui::IsItemHovered())
@@ -1205,7 +1231,7 @@ void MediaController::Render()
             // display media information
             if (ImGui::IsItemHovered()) {
 
-                float tooltip_height = 3.f * ImGui::GetTextLineHeightWithSpacing();
+                float tooltip_height = 6.f * ImGui::GetTextLineHeightWithSpacing();
 
                 ImDrawList* draw_list = ImGui::GetWindowDrawList();
                 draw_list->AddRectFilled(ImVec2(tooltip_pos.x - 10.f, tooltip_pos.y),
@@ -1218,6 +1244,19 @@ void MediaController::Render()
                     ImGui::Text(" %d x %d px, %.2f / %.2f fps", mp_->width(), mp_->height(), mp_->updateFrameRate() , mp_->frameRate() );
                 else
                     ImGui::Text(" %d x %d px", mp_->width(), mp_->height());
+                ImGui::Text(" Queue %.1f / %d frames, %d dropped, cache %d MB", mp_->queueOccupancy(), mp_->queueSize(),
+                            mp_->droppedFrames(), int(mp_->cacheSize() / 1048576) );
+                ImGui::Text(" Decoding %.1f ms / frame, %d thread(s)", mp_->decodeTime(), mp_->decoderThreads());
+                if ( mp_->isHibernating() )
+                    ImGui::Text(" Hibernating");
+                else if ( mp_->clipResident() )
+                    ImGui::Text(" Clip cache %d MB, %.0f%% hits", int(mp_->clipCacheSize() / 1048576), mp_->clipHitRate() * 100.f);
+                else if ( mp_->clipCache() )
+                    ImGui::Text(" Clip cache %d MB, filling", int(mp_->clipCacheSize() / 1048576));
+                else if ( mp_->usesProxy() )
+                    ImGui::Text(" Decoding proxy");
+                else if ( mp_->proxyProgress() >= 0.f )
+                    ImGui::Text(" Transcoding proxy %.0f%%", mp_->proxyProgress() * 100.f);
 
             }
 
@@ -1275,6 +1314,14 @@ void MediaController::Render()
             current_loop = (int) mp_->loop();
             if ( ImGuiToolkit::ButtonIconMultistate(iconsloop, &current_loop) )
                 mp_->setLoop( (MediaPlayer::LoopMode) current_loop );
+            // clip cache toggle (short media only)
+            if ( mp_->timeline().duration() < CLIP_CACHE_MAX_DURATION ) {
+                ImGui::SameLine(0, spacing);
+                bool clip = mp_->clipCache();
+                ImGuiToolkit::ButtonToggle(ICON_FA_MEMORY, &clip);
+                if ( clip != mp_->clipCache() )
+                    mp_->setClipCache(clip);
+            }
             // speed slider
             float speed = static_cast<float>(mp_->playSpeed());
             ImGui::SameLine(0, spacing);
@@ -1344,8 +1391,10 @@ void MediaController::Render()
 //                ImGui::PlotHistogram("##TimelineHistogram", array, array_size-1.f, 0, NULL, 0.0f, 1.0f, size);
 
                 // custom timeline slider
-                slider_pressed_ = ImGuiToolkit::TimelineSlider("##timeline", &seek_t,
-                                                               mp_->timeline().end(), mp_->timeline().step(), size.x);
+                // key frames are marked on the timeline once the media is indexed
+                Timeline timeline = mp_->timeline();
+                slider_pressed_ = ImGuiToolkit::TimelineSlider("##timeline", &seek_t, timeline.end(), timeline.step(), size.x,
+                                                               timeline.isIndexed() ? &timeline.keyframes() : nullptr);
 
                 ImGui::PopStyleVar(2);
             }
@@ -1368,10 +1417,8 @@ void MediaController::Render()
             bool media_play = media_playing_mode_ & (!slider_pressed_);
 
             // apply play action to media only if status should change
-            // NB: The seek command performed an ASYNC state change, but
-            // gst_element_get_state called in isPlaying(true) will wait
-            // for the state change to complete : do not remove it!
-// TODO : DO NOT ask for status every frame : high performance cost
+            // NB: The seek command performed an ASYNC state change,
+            // isPlaying() answers with the requested state (never waits)
             if ( mp_->isPlaying() != media_play ) {
                 mp_->play( media_play );
             }
@@ -1866,6 +1913,29 @@ void Navigator::RenderNewPannel()
                 }
             }
 
+            // clic button to select a folder of numbered images
+            if ( ImGui::Button( ICON_FA_FOLDER_OPEN " Open image sequence", ImVec2(ImGui::GetContentRegionAvail().x IMGUI_RIGHT_ALIGN, 0)) ) {
+                if (sequenceFolderDialogs.empty()) {
+                    sequenceFolderDialogs.emplace_back(  std::async(std::launch::async, FolderDialog, Settings::application.recentImport.path) );
+                    fileDialogPending_ = true;
+                }
+            }
+            ImGui::SameLine();
+            ImGuiToolkit::HelpMarker("Create a source playing a folder of\nnumbered images (*.png, *.jpg, etc.)\nin the order of their numbers.");
+
+            // if a folder dialog future was registered
+            if ( !sequenceFolderDialogs.empty() ) {
+                if (sequenceFolderDialogs.back().wait_for(timeout) == std::future_status::ready ) {
+                    std::string open_folder = sequenceFolderDialogs.back().get();
+                    sequenceFolderDialogs.pop_back();
+                    fileDialogPending_ = false;
+                    if (!open_folder.empty()) {
+                        std::string label = open_folder.substr( open_folder.size() - MIN( 35, open_folder.size()) );
+                        new_source_preview_.setSource( Mixer::manager().createSourceSequence(open_folder), label);
+                    }
+                }
+            }
+
             // combo of recent media filenames
             ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
             if (ImGui::BeginCombo("##RecentImport", IMGUI_LABEL_RECENT_FILES))
@@ -2444,7 +2514,50 @@ void ShowConfig(bool* p_open)
         bool vsync = (Settings::application.render.vsync < 2);
         ImGui::Checkbox("Sync refresh with monitor (v-sync 60Hz)", &vsync);
         Settings::application.render.vsync = vsync ? 1 : 2;
+        ImGui::Checkbox("Video color conversion on GPU (YUV upload & recording)", &Settings::application.render.gpu_colorspace);
+        ImGui::Checkbox("Video resolution adapted to display (scale down)", &Settings::application.media.adaptive_resolution);
         ImGui::Text( ICON_FA_EXCLAMATION "  Restart the application for change to take effect.");
+
+        ImGui::Text("\nProxy of heavy videos (high resolution or bitrate).");
+        ImGui::Checkbox("Transcode in background and play the proxy", &Settings::application.media.proxy);
+        ImGui::SetNextItemWidth(200);
+        ImGui::Combo("Encoding", &Settings::application.media.proxy_profile, VideoRecorder::profile_name, IM_ARRAYSIZE(VideoRecorder::profile_name) );
+        static const char* proxy_height_name[4] = { "Original", "540p", "720p", "1080p" };
+        static const int proxy_height[4] = { 0, 540, 720, 1080 };
+        int h = 0;
+        while ( h < 3 && proxy_height[h] != Settings::application.media.proxy_height )
+            h++;
+        ImGui::SetNextItemWidth(200);
+        if ( ImGui::Combo("Resolution", &h, proxy_height_name, IM_ARRAYSIZE(proxy_height_name) ) )
+            Settings::application.media.proxy_height = proxy_height[h];
+
+        // folder of proxy files
+        if ( ImGui::Button( ICON_FA_FOLDER_PLUS " Folder") && proxyFolderDialogs.empty() )
+            proxyFolderDialogs.emplace_back( std::async(std::launch::async, FolderDialog, MediaPlayer::proxyPath()) );
+        ImGui::SameLine();
+        ImGuiToolkit::ButtonOpenUrl( MediaPlayer::proxyPath().c_str() );
+        if ( !proxyFolderDialogs.empty() && proxyFolderDialogs.back().wait_for(timeout) == std::future_status::ready ) {
+            std::string folder = proxyFolderDialogs.back().get();
+            if (!folder.empty())
+                Settings::application.media.proxy_path = folder;
+            proxyFolderDialogs.pop_back();
+        }
+        if ( MediaPlayer::proxyPending() > 0 )
+            ImGui::Text( ICON_FA_HOURGLASS_HALF "  %d video(s) waiting for transcoding", MediaPlayer::proxyPending());
+
+        ImGui::Text("\nHibernation of inactive videos (release memory).");
+        ImGui::SetNextItemWidth(200);
+        ImGui::SliderInt("RAM budget", &Settings::application.media.ram_budget, 0, 16384,
+                         Settings::application.media.ram_budget > 0 ? "%d MB" : "Unlimited");
+        ImGui::SetNextItemWidth(200);
+        ImGui::SliderInt("VRAM budget", &Settings::application.media.vram_budget, 0, 8192,
+                         Settings::application.media.vram_budget > 0 ? "%d MB" : "Unlimited");
+        ImGui::SetNextItemWidth(200);
+        ImGui::SliderInt("Inactive delay", &Settings::application.media.hibernate_delay, 0, 300, "%d s");
+        gsize ram = 0, vram = 0, cache = 0;
+        MediaPlayer::memoryUsage(ram, vram, cache);
+        ImGui::Text( ICON_FA_MEMORY "  Videos use %d MB RAM, %d MB VRAM", int(ram / 1048576), int(vram / 1048576));
+        ImGui::Text( ICON_FA_MEMORY "  Caches of frames use %d MB RAM", int(cache / 1048576));
     }
 
     ImGui::End();
@@ -2608,5 +2721,49 @@ void ShowAboutGStreamer(bool* p_open)
         ImGui::EndChildFrame();
     }
 
+    // benchmark of decoders for the codecs of the current session
+    ImGui::Separator();
+    static std::atomic<float> benchmark_progress = 0.f;
+    static std::vector< std::future< std::map<std::string, std::list<std::string> > > > benchmarks;
+    if ( benchmarks.empty() ) {
+        if ( ImGui::Button( ICON_FA_TACHOMETER_ALT " Benchmark decoders of session" ) ) {
+            std::list<std::string> uris;
+            SourceList::iterator iter;
+            for (iter = Mixer::manager().session()->begin(); iter != Mixer::manager().session()->end(); iter++) {
+                MediaSource *ms = dynamic_cast<MediaSource *>(*iter);
+                if (ms)
+                    uris.push_back( ms->mediaplayer()->uri() );
+            }
+            uris.sort();
+            uris.unique();
+            benchmark_progress = 0.f;
+            benchmarks.emplace_back( std::async(std::launch::async, GstToolkit::rank_decoders, uris, &benchmark_progress) );
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Decode videos of the session with each decoder\nand prefer the fastest using less processor.");
+    }
+    else {
+        ImGui::ProgressBar(benchmark_progress, ImVec2(-FLT_MIN, 0.f), "Benchmarking decoders...");
+        if ( benchmarks.back().wait_for(timeout) == std::future_status::ready ) {
+            std::map<std::string, std::list<std::string> > ranking = benchmarks.back().get();
+            for (auto it = ranking.begin(); it != ranking.end(); ++it)
+                Settings::application.media.decoders[it->first] = it->second;
+            GstToolkit::apply_decoders_ranking(ranking);
+            benchmarks.clear();
+        }
+    }
+    if ( !Settings::application.media.decoders.empty() ) {
+        for (auto it = Settings::application.media.decoders.begin(); it != Settings::application.media.decoders.end(); ++it) {
+            std::string decoders;
+            for (auto d = it->second.begin(); d != it->second.end(); ++d)
+                decoders += (d == it->second.begin() ? "" : ", ") + *d;
+            ImGui::Text("%s : %s", it->first.c_str(), decoders.c_str());
+        }
+        if ( ImGui::Button( ICON_FA_UNDO " Reset ranking" ) ) {
+            Settings::application.media.decoders.clear();
+            Log::Notify("Default ranking of decoders will be restored at next start.");
+        }
+    }
+
     ImGui::End();
 }
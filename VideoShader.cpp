@@ -0,0 +1,56 @@
+#include <glad/glad.h>
+
+#include "defines.h"
+#include "VideoShader.h"
+#include "Resource.h"
+
+static ShadingProgram videoShadingProgram("shaders/image.vs", "shaders/video.fs");
+
+const char* VideoShader::deinterlace_name[4] = { "None", "Bob", "Linear blend", "Motion adaptive" };
+
+VideoShader::VideoShader(): Shader()
+{
+    // static program shader
+    program_ = &videoShadingProgram;
+    // reset instance
+    reset();
+}
+
+void VideoShader::use()
+{
+    Shader::use();
+
+    program_->setUniform("format", (int) format);
+    program_->setUniform("colormatrix", (int) colormatrix);
+    program_->setUniform("fullrange", fullrange);
+    program_->setUniform("iChannel2", 2);
+    program_->setUniform("iChannel3", 3);
+    program_->setUniform("deinterlace", (int) deinterlace);
+    program_->setUniform("field", field);
+
+    // plane 0 is bound on texture unit 0 by the surface, bind others
+    for (int i = 1; i < N_VPLANES; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, planes[i] > 0 ? planes[i] : Resource::getTextureBlack());
+    }
+    glActiveTexture(GL_TEXTURE0 + N_VPLANES);
+    glBindTexture(GL_TEXTURE_2D, previous > 0 ? previous : Resource::getTextureBlack());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VideoShader::reset()
+{
+    Shader::reset();
+
+    // conversion does not blend
+    blending = BLEND_CUSTOM;
+
+    format = FORMAT_RGBA;
+    colormatrix = MATRIX_BT601;
+    fullrange = false;
+    for (int i = 0; i < N_VPLANES; ++i)
+        planes[i] = 0;
+    deinterlace = DEINTERLACE_NONE;
+    field = 0;
+    previous = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef VIDEOSHADER_H
+#define VIDEOSHADER_H
+
+#ifdef __APPLE__
+#include <sys/types.h>
+#endif
+
+#include "Shader.h"
+
+#define N_VPLANES 3
+
+/**
+ * @brief The VideoShader class converts the planes of a decoded video frame
+ * into an RGBA image.
+ *
+ * It is used by the MediaPlayer to render its frames into a FrameBuffer
+ * when the frames are uploaded in their native YUV layout.
+ * The texture of plane 0 is bound by the Surface being drawn,
+ * the other planes are bound by the shader.
+ *
+ * Interlaced frames are deinterlaced during the conversion; the
+ * motion adaptive mode compares plane 0 with the one of the previous frame.
+ */
+class VideoShader : public Shader
+{
+
+public:
+
+    typedef enum {
+        FORMAT_RGBA = 0,
+        FORMAT_I420,
+        FORMAT_NV12,
+        FORMAT_YUY2
+    } Format;
+
+    typedef enum {
+        MATRIX_BT601 = 0,
+        MATRIX_BT709
+    } ColorMatrix;
+
+    typedef enum {
+        DEINTERLACE_NONE = 0,
+        DEINTERLACE_BOB,
+        DEINTERLACE_LINEAR,
+        DEINTERLACE_ADAPTIVE
+    } Deinterlace;
+    static const char* deinterlace_name[4];
+
+    VideoShader();
+
+    void use() override;
+    void reset() override;
+
+    Format format;
+    ColorMatrix colormatrix;
+    bool fullrange;
+    uint planes[N_VPLANES];
+
+    Deinterlace deinterlace;
+    int field;      // parity of the rows of the field displayed
+    uint previous;  // plane 0 of the previous frame
+};
+
+#endif // VIDEOSHADER_H
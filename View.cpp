@@ -428,14 +428,21 @@ View::Cursor MixingView::grab (Source *s, glm::vec2 from, glm::vec2 to, std::pai
     // Interaction with source
     //
     // compute delta translation
+    glm::vec2 previous = glm::vec2(s->group(mode_)->translation_);
     s->group(mode_)->translation_ = s->stored_status_->translation_ + gl_Position_to - gl_Position_from;
 
+    // anticipate where the source is going with the velocity of the drag
+    glm::vec2 velocity = ( glm::vec2(s->group(mode_)->translation_) - previous ) / MAX(ImGui::GetIO().DeltaTime, 0.001f);
+    s->predict( glm::vec2(s->group(mode_)->translation_) + velocity * MIXING_PREROLL_DELAY );
+
     // request update
     s->touch();
 
     std::ostringstream info;
     if (s->active())
         info << "Alpha " << std::fixed << std::setprecision(3) << s->blendingShader()->color.a;
+    else if (s->prerolling())
+        info << "Inactive (pre-rolling)";
     else
         info << "Inactive";
 
@@ -26,6 +26,8 @@ class ImageShader;
 class ImageProcessingShader;
 class Source;
 class MediaSource;
+class ImageSource;
+class SequenceSource;
 class SessionSource;
 class RenderSource;
 class CloneSource;
@@ -61,6 +63,8 @@ public:
     // utility
     virtual void visit (Source&) {}
     virtual void visit (MediaSource&) {}
+    virtual void visit (ImageSource&) {}
+    virtual void visit (SequenceSource&) {}
     virtual void visit (SessionSource&) {}
     virtual void visit (RenderSource&) {}
     virtual void visit (CloneSource&) {}
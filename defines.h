@@ -31,6 +31,11 @@
 #define MIXING_DEFAULT_SCALE 2.4f
 #define MIXING_MIN_SCALE 0.8f
 #define MIXING_MAX_SCALE 7.0f
+#define MIXING_ACTIVE_DISTANCE 1.3f
+#define MIXING_PREROLL_DELAY 0.5f     // s, anticipation of the movement of sources
+#define MIXING_PREROLL_TIMEOUT 1000.f // ms, pre-roll of a source without new prediction
+#define SOURCE_THUMBNAIL_HEIGHT 128   // px, frame kept by hibernating sources
+#define SOURCE_TRANSPARENT_DELAY 2000.f // ms, before decoding a transparent source at lowest resolution
 #define GEOMETRY_DEFAULT_SCALE 1.2f
 #define GEOMETRY_MIN_SCALE 0.2f
 #define GEOMETRY_MAX_SCALE 10.0f
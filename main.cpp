@@ -28,6 +28,7 @@
 #include "Mixer.h"
 #include "RenderingManager.h"
 #include "UserInterfaceManager.h"
+#include "MediaPlayer.h"
 
 
 void drawScene()
@@ -97,6 +98,11 @@ int main(int, char *argv[])
     ///
     Rendering::manager().terminate();
 
+    ///
+    /// MEDIA TERMINATE
+    ///
+    MediaPlayer::terminate();
+
     ///
     /// Settings
     ///
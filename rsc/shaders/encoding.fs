@@ -0,0 +1,30 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec4 vertexColor;
+in vec2 vertexUV;
+
+uniform sampler2D iChannel0;             // RGB(A) image to encode
+uniform vec3      iResolution;           // viewport resolution (in pixels)
+
+uniform vec4 color;
+uniform int  plane;       // 0: Y, 1: U (Cb), 2: V (Cr)
+
+void main()
+{
+    // subsampled planes are rendered in a smaller viewport:
+    // linear filtering averages the pixels covered by a chroma sample
+    vec3 rgb = clamp( texture(iChannel0, vertexUV).rgb, 0.0, 1.0);
+
+    // BT.709 conversion, to limited range [16 235] and [16 240]
+    float value;
+    if (plane == 1)
+        value = 0.5 + 0.878431 * dot(rgb, vec3(-0.114572, -0.385428, 0.5));
+    else if (plane == 2)
+        value = 0.5 + 0.878431 * dot(rgb, vec3(0.5, -0.454153, -0.045847));
+    else
+        value = 0.0625 + 0.858824 * dot(rgb, vec3(0.2126, 0.7152, 0.0722));
+
+    FragColor = vec4(value, value, value, 1.0);
+}
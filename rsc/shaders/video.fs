@@ -0,0 +1,118 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec4 vertexColor;
+in vec2 vertexUV;
+
+uniform sampler2D iChannel0;             // plane 0 (Y, YUYV or RGBA)
+uniform sampler2D iChannel1;             // plane 1 (U or UV)
+uniform sampler2D iChannel2;             // plane 2 (V)
+uniform sampler2D iChannel3;             // plane 0 of the previous frame
+uniform vec3      iResolution;           // viewport resolution (in pixels)
+
+uniform vec4 color;
+uniform int  format;      // 0: RGBA, 1: I420, 2: NV12, 3: YUY2
+uniform int  colormatrix; // 0: BT601, 1: BT709
+uniform bool fullrange;   // true for [0 255] range, false for [16 235]
+uniform int  deinterlace; // 0: none, 1: bob, 2: linear blend, 3: motion adaptive
+uniform int  field;       // parity of the rows of the field displayed (0: top, 1: bottom)
+
+vec3 yuv2rgb(vec3 yuv)
+{
+    // expand limited range to full range
+    if (!fullrange) {
+        yuv.x = (yuv.x - 0.0625) * 1.164383;
+        yuv.yz = (yuv.yz - 0.5) * 1.138393;
+    }
+    else
+        yuv.yz -= 0.5;
+
+    // BT.709 (HD) and BT.601 (SD) conversion matrices
+    if (colormatrix > 0)
+        return vec3( yuv.x + 1.5748 * yuv.z,
+                     yuv.x - 0.1873 * yuv.y - 0.4681 * yuv.z,
+                     yuv.x + 1.8556 * yuv.y );
+    else
+        return vec3( yuv.x + 1.4020 * yuv.z,
+                     yuv.x - 0.3441 * yuv.y - 0.7141 * yuv.z,
+                     yuv.x + 1.7720 * yuv.y );
+}
+
+vec4 convert(ivec2 pixel)
+{
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(iChannel0, 0));
+
+    vec3 yuv = vec3(0.0);
+    vec4 rgba = vec4(0.0, 0.0, 0.0, 1.0);
+
+    if (format == 1) {
+        // I420: three planes, chroma sub-sampled 2x2
+        yuv.x = texelFetch(iChannel0, pixel, 0).r;
+        yuv.y = texture(iChannel1, uv).r;
+        yuv.z = texture(iChannel2, uv).r;
+        rgba.rgb = yuv2rgb(yuv);
+    }
+    else if (format == 2) {
+        // NV12: Y plane and interleaved UV plane, chroma sub-sampled 2x2
+        yuv.x = texelFetch(iChannel0, pixel, 0).r;
+        yuv.yz = texture(iChannel1, uv).rg;
+        rgba.rgb = yuv2rgb(yuv);
+    }
+    else if (format == 3) {
+        // YUY2: packed Y0 U Y1 V macro-pixels, uploaded as RGBA of half width
+        vec4 macro = texelFetch(iChannel0, ivec2(pixel.x / 2, pixel.y), 0);
+        yuv.x = (pixel.x % 2 > 0) ? macro.b : macro.r;
+        yuv.yz = macro.ga;
+        rgba.rgb = yuv2rgb(yuv);
+    }
+    else
+        rgba = texelFetch(iChannel0, pixel, 0);
+
+    return rgba;
+}
+
+float luma(sampler2D plane, ivec2 pixel)
+{
+    if (format == 1 || format == 2)
+        return texelFetch(plane, pixel, 0).r;
+    else if (format == 3) {
+        vec4 macro = texelFetch(plane, ivec2(pixel.x / 2, pixel.y), 0);
+        return (pixel.x % 2 > 0) ? macro.b : macro.r;
+    }
+    return dot(texelFetch(plane, pixel, 0).rgb, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    // the conversion is done pixel to pixel in a frame buffer of the size of the video
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 rgba = convert(pixel);
+
+    if (deinterlace > 0) {
+        // rows of both fields around the pixel
+        int last = textureSize(iChannel0, 0).y - 1;
+        ivec2 above = ivec2(pixel.x, max(pixel.y - 1, 0));
+        ivec2 below = ivec2(pixel.x, min(pixel.y + 1, last));
+        // the row belongs to the other field than the one displayed
+        bool other = (pixel.y % 2) != field;
+
+        if (deinterlace == 1) {
+            // bob: rows of the other field are interpolated from the field displayed
+            if (other)
+                rgba = 0.5 * (convert(above) + convert(below));
+        }
+        else if (deinterlace == 2) {
+            // linear blend: both fields are mixed (vertical low-pass)
+            rgba = 0.5 * rgba + 0.25 * (convert(above) + convert(below));
+        }
+        else if (other) {
+            // motion adaptive: rows of the other field are kept where the picture is still,
+            // and interpolated from the field displayed where it changed since previous frame
+            float motion = abs(luma(iChannel0, pixel) - luma(iChannel3, pixel));
+            rgba = mix(rgba, 0.5 * (convert(above) + convert(below)), smoothstep(0.02, 0.08, motion));
+        }
+    }
+
+    FragColor = rgba * color;
+}